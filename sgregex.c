@@ -1,13 +1,27 @@
 
 
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#  define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#endif
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <assert.h>
+#if defined(RX_USE_AVX2) && defined(__AVX2__)
+#  include <immintrin.h>
+#endif
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
 
 #define RX_NEED_DEFAULT_MEMFUNC
 #define _srx_Context rxExecute
+#define _srx_Stream rxStream
+#define _srx_Template rxTemplate
+#define _srx_Lexer rxLexer
 #include "sgregex.h"
 
 
@@ -17,12 +31,26 @@
 #define RX_MAX_CAPTURES 10
 #define RX_MAX_SUBEXPRS 255
 #define RX_MAX_REPEATS 0xffffffff
-#define RX_NULL_OFFSET 0xffffffff
 #define RX_NULL_INSTROFF 0x0fffffff
 
+/* offset width - define RX_LARGE_OFFSETS for strings over 256 MB */
+#ifdef RX_LARGE_OFFSETS
+typedef size_t rxOffset;
+#  define RX_NULL_OFFSET ((size_t)-1)
+#  define RX_MAX_OFFSET ((size_t)-2)
+#  define RX_OFFSET_MASK ((size_t)-1)
+#else
+typedef uint32_t rxOffset;
+#  define RX_NULL_OFFSET 0xffffffff
+#  define RX_MAX_OFFSET 0x0fffffff
+#  define RX_OFFSET_MASK 0x0fffffff
+#endif
+
 #define RCF_MULTILINE 0x01 /* ^/$ matches beginning/end of line too */
 #define RCF_CASELESS  0x02 /* pre-equalized case for match/range */
 #define RCF_DOTALL    0x04 /* "." is compiled as "[^]" instead of "[^\r\n]" */
+#define RCF_STICKY    0x08 /* searches only try the start offset */
+#define RCF_LONGEST   0x10 /* leftmost-longest (POSIX) matches, found by automata */
 
 
 #define RX_OP_MATCH_DONE        0 /* end of regexp */
@@ -52,10 +80,17 @@ rxInstr;
 #define RX_STATE_BACKTRACKED 0x1
 typedef struct rxState
 {
+#ifdef RX_LARGE_OFFSETS
+	rxOffset off;       /* offset in string */
+	rxOffset numiters;  /* current iteration count / previous capture value */
+	uint32_t instr;     /* instruction */
+	uint32_t flags;
+#else
 	uint32_t off : 28;  /* offset in string */
 	uint32_t flags : 4;
 	uint32_t instr;     /* instruction */
 	uint32_t numiters;  /* current iteration count / previous capture value */
+#endif
 }
 rxState;
 
@@ -105,6 +140,15 @@ struct rxExecute
 	rxChar*    chars;  /* character data (ranges and plain sequences for opcodes) */
 	uint8_t    flags;
 	uint8_t    capture_count;
+	rxChar*    pattern; /* source of the pattern (null-terminated copy, NULL for private executors) */
+	size_t     pattern_size;
+	srx_Analysis analysis; /* program properties and the selected engine (backtracking only for private executors) */
+	
+	/* slow call reporting */
+	srx_SlowFunc slow_fn;
+	void*      slow_userdata;
+	size_t     slow_steps;
+	double     slow_seconds;
 	
 	/* runtime data */
 	rxState*   states;
@@ -114,13 +158,196 @@ struct rxExecute
 	size_t     iternum_count;
 	size_t     iternum_mem;
 	const rxChar* str;
-	uint32_t   captures[ RX_MAX_CAPTURES ][2];
+	rxOffset   captures[ RX_MAX_CAPTURES ][2];
+	uint8_t    hit_end; /* set if the result depended on the end of the string */
+	srx_Stats  stats;
+	
+	/* automata (built on first use) */
+	struct rxDFA* dfa;
+	uint8_t    dfa_built;
+	struct rxDFA* rdfa[ 3 ]; /* reversed program in each RX_DFA_* mode: last match start, end-anchored searches, two-phase searches */
+	uint8_t    rdfa_built; /* bit of each mode */
+	struct rxDFA* ldfa; /* anchored DFA of leftmost-longest contexts (built on creation, borrowed by private executors) */
+	struct rxOnePass* onepass; /* capture table of one-pass programs (built on creation) */
+	struct rxBitNFA* bnfa; /* bit-parallel automaton of small programs */
+	uint8_t    bnfa_built;
+	
+#ifdef RX_PROFILE
+	srx_InstrProfile* prof; /* per-instruction counters, NULL for private executors */
+	size_t     prof_count;
+#endif
 };
 typedef struct rxExecute rxExecute;
 
+struct rxStream
+{
+	rxExecute* R;
+	srx_MatchFunc fn;
+	void*      userdata;
+	
+	rxChar*    buf;  /* unresolved part of the stream */
+	size_t     buf_size;
+	size_t     buf_mem;
+	size_t     base; /* stream offset of the first buffered character */
+	size_t     pos;  /* buffer offset of the next match attempt */
+	int        stopped;
+	
+	/* the attempt at `pos` that needed more input is retried once the anchored DFA dies or the buffer reaches `retry` */
+	size_t     retry;   /* 0 if no attempt is pending */
+	size_t     scanned; /* buffer offset the DFA has read up to */
+	uint32_t   row;
+	struct rxDFA* dfa;  /* NULL if the pattern has none */
+	int        dfa_built;
+};
+typedef struct rxStream rxStream;
+
+typedef struct rxTplPart
+{
+	size_t     from; /* beginning of character data */
+	size_t     len;  /* length of character data */
+	int        slot; /* capture slot to insert or -1 for character data */
+}
+rxTplPart;
+
+struct rxTemplate
+{
+	srx_MemFunc memfn;
+	void*      memctx;
+	
+	rxTplPart* parts;
+	size_t     parts_count;
+	rxChar*    chars;
+	size_t     chars_count;
+};
+typedef struct rxTemplate rxTemplate;
+
+struct rxLexer
+{
+	struct rxExecute e; /* allocation only, holds no program */
+	struct rxDFA* dfa;  /* anchored DFA of all patterns */
+	size_t     count;
+};
+typedef struct rxLexer rxLexer;
+
+
+#define RX_NFA_MAX_NODES  4096
+#define RX_DFA_MAX_STATES 1024
+#define RX_LEX_MAX_STATES 16384
+#define RX_TWO_PHASE_MIN  256 /* shorter inputs are searched by the backtracker alone */
+#define RX_NODE_NONE      0xffffffff
+
+#define RX_NODE_CHAR    0 /* match a character from the set, continue at `out` */
+#define RX_NODE_SPLIT   1 /* continue at `out`, then (lower priority) at `out1` */
+#define RX_NODE_CAPTURE 2 /* save position to capture slot `arg` / 2 (start if even, end if odd) */
+#define RX_NODE_BOS     3 /* string start */
+#define RX_NODE_EOS     4 /* string end */
+#define RX_NODE_MATCH   5 /* end of regexp `arg` (pattern index of a lexer) */
+
+typedef struct rxNode
+{
+	uint16_t type;
+	uint16_t arg;  /* character set / capture slot */
+	uint32_t out;
+	uint32_t out1;
+}
+rxNode;
+
+/* program decoded into a Thompson NFA, for automaton-based engines */
+typedef struct rxNFA
+{
+	rxNode*    nodes;
+	uint32_t   nodes_count;
+	uint32_t   nodes_mem;
+	uint32_t   start;
+	
+	uint32_t*  sets;  /* 256-bit character sets, 8 words each */
+	uint32_t   sets_count;
+	uint32_t   sets_mem;
+	
+	uint8_t    classes[ 256 ]; /* byte -> class of bytes with the same membership in all sets */
+	uint32_t   classes_count;
+	
+	uint8_t    reverse; /* built for matching backwards (string end first) */
+}
+rxNFA;
+
+#define RX_SET_HAS( set, b ) (((set)[ (b) >> 5 ] >> ( (b) & 31 )) & 1)
+
+#define RX_DFA_MATCH    0x1 /* a match ended before the current position */
+#define RX_DFA_EOSMATCH 0x2 /* a match ends at the current position if it is the string end */
+
+#define RX_DFA_SEARCH   0 /* finds whether there is a match anywhere, state 0 is the match sink */
+#define RX_DFA_ANCHORED 1 /* follows matches starting at one position, state 0 is the dead state */
+#define RX_DFA_PREFIX   2 /* like RX_DFA_ANCHORED, but the start state is every node, so that any part of a match is followed */
+
+/* search or anchored DFA, row 0 is state 0 */
+typedef struct rxDFA
+{
+	uint32_t*  trans;  /* next row (state * classes_count) at [ row + class ] */
+	uint8_t*   accept; /* RX_DFA_* flags of each state (search DFA) */
+	uint32_t*  tokens; /* 1 + the lowest index of a pattern that matches up to the state, 0 if none,
+	                      at [ state * 2 ] before other characters and at [ state * 2 + 1 ] at the string end (anchored DFA) */
+	uint32_t   states_count;
+	uint32_t   classes_count;
+	uint32_t   start_row;
+	uint32_t   mid_row; /* start row for searches that begin after the string start */
+	uint8_t    classes[ 256 ];
+	int32_t    classes32[ 256 ]; /* widened copy for gathers */
+}
+rxDFA;
+
+#define RX_ONEPASS_NEXT  0x3fffffff /* next state, 0 (the start state at the string start) if the attempt fails */
+#define RX_ONEPASS_SAVE  0x40000000 /* a lower-priority match ends before the character, it is the result if the rest fails */
+#define RX_ONEPASS_MATCH 0x80000000 /* the match ends before the character */
+
+/* one-pass program: at each position at most one path of the NFA can lead to a match,
+   so a single forward walk finds the captures of the backtracking matcher, state 0 / 1 start at / after the string start */
+typedef struct rxOnePass
+{
+	uint32_t*  acts;   /* RX_ONEPASS_* at [ state * classes_count + class ] */
+	uint32_t*  caps;   /* capture slots (2 per group) set to the position by the path that continues or matches */
+	uint32_t*  saves;  /* capture slots of the RX_ONEPASS_SAVE match */
+	uint32_t*  ends;   /* capture slots of the match at the string end, RX_ONEPASS_MATCH if there is one */
+	uint32_t   states_count;
+	uint32_t   classes_count;
+	uint8_t    classes[ 256 ];
+}
+rxOnePass;
+
+#define RX_BIT_MAX_POSITIONS 64
+
+/* Glushkov automaton of a small program for bit-parallel simulation: a position is a character node of the NFA,
+   a state is the set of positions that read the last character, one bit each */
+typedef struct rxBitNFA
+{
+	uint64_t   masks[ 256 ]; /* positions that can read the byte */
+	uint64_t   first[ 2 ];   /* positions read first by a match, [0] at the string start, [1] elsewhere */
+	uint64_t   last[ 2 ];    /* positions a match can end after, [0] before another character, [1] at the string end */
+	uint64_t*  follow;       /* positions read after any of 8 positions, at [ k * 256 + bits k * 8 .. k * 8 + 7 of the state ] */
+	uint64_t*  precede;      /* positions read before any of 8 positions, same layout */
+	uint32_t   tables_count;
+	uint8_t    empty[ 2 ][ 2 ]; /* an empty match is possible [at the string start][at the string end] */
+}
+rxBitNFA;
+
 #define RX_NUM_ITERS( e ) ((e)->iternum[ (e)->iternum_count - 1 ])
 #define RX_LAST_STATE( e ) ((e)->states[ (e)->states_count - 1 ])
 
+/* profiling counters - compiled out unless RX_PROFILE is defined */
+#ifdef RX_PROFILE
+#  define RX_PROF( e, instr, field ) ((e)->prof ? (void)( (e)->prof[ instr ].field++ ) : (void) 0)
+#  define RX_PROF_EXEC( e, instr ) ((e)->prof ? rxProfExec( (e)->prof + (instr), (e)->states_count ) : (void) 0)
+static void rxProfExec( srx_InstrProfile* p, size_t states_count )
+{
+	p->exec++;
+	if( states_count > p->peak_states )
+		p->peak_states = states_count;
+}
+#else
+#  define RX_PROF( e, instr, field )
+#  define RX_PROF_EXEC( e, instr )
+#endif
+
 
 #define RX_STRLITBUF( x ) (x), (sizeof(x)-1)
 #define rxIsDigit( v ) ((v) >= '0' && (v) <= '9')
@@ -179,8 +406,49 @@ static int rxMatchCharset( const rxChar* ch, const rxChar* charset, size_t cslen
 	return 0;
 }
 
+/* instructions that match exactly one character */
+#define RX_INSTR_IS_CHAR( ip ) ((ip)->op == RX_OP_MATCH_CHARSET || (ip)->op == RX_OP_MATCH_CHARSET_INV || \
+	( (ip)->op == RX_OP_MATCH_STRING && (ip)->len == 1 ))
+
+/* length of the run of characters at `str` (at most `limit`) matched by the single character instruction `op` */
+static size_t rxScanChars( const rxInstr* op, const rxChar* chars, const rxChar* str, size_t limit, int ignore_case )
+{
+	size_t i = 0;
+	if( op->op == RX_OP_MATCH_STRING )
+	{
+		rxChar c = chars[ op->from ];
+		if( ignore_case )
+		{
+			c = rxToLower( c );
+			while( i < limit && rxToLower( str[ i ] ) == c )
+				i++;
+		}
+		else
+		{
+			while( i < limit && str[ i ] == c )
+				i++;
+		}
+	}
+	else if( op->len == 2 && !ignore_case )
+	{
+		/* one range, tested with a single unsigned comparison */
+		rxUChar lo = (rxUChar) chars[ op->from ];
+		rxUChar span = (rxUChar)( (rxUChar) chars[ op->from + 1 ] - lo );
+		int inv = op->op == RX_OP_MATCH_CHARSET_INV;
+		while( i < limit && ( (rxUChar)( (rxUChar) str[ i ] - lo ) <= span ) != inv )
+			i++;
+	}
+	else
+	{
+		int inv = op->op == RX_OP_MATCH_CHARSET_INV;
+		while( i < limit && rxMatchCharset( &str[ i ], &chars[ op->from ], op->len, ignore_case ) != inv )
+			i++;
+	}
+	return i;
+}
+
 
-void rxDumpToFile( rxInstr* instrs, rxChar* chars, FILE* fp )
+void rxDumpToFile( rxInstr* instrs, rxChar* chars, const srx_InstrProfile* prof, FILE* fp )
 {
 	size_t i;
 	rxInstr* ip = instrs;
@@ -193,7 +461,7 @@ void rxDumpToFile( rxInstr* instrs, rxChar* chars, FILE* fp )
 		case RX_OP_MATCH_DONE:
 			fprintf( fp, "MATCH_DONE\n" );
 			break;
-			
+		
 		case RX_OP_MATCH_CHARSET:
 		case RX_OP_MATCH_CHARSET_INV:
 			fprintf( fp, "%s (ranges[%u]=",
@@ -211,7 +479,7 @@ void rxDumpToFile( rxInstr* instrs, rxChar* chars, FILE* fp )
 			}
 			fprintf( fp, ")\n" );
 			break;
-			
+		
 		case RX_OP_MATCH_STRING:
 			fprintf( fp, "MATCH_STRING (str[%u]=", (unsigned) ip->len );
 			for( i = ip->from; i < ip->from + ip->len; ++i )
@@ -224,43 +492,50 @@ void rxDumpToFile( rxInstr* instrs, rxChar* chars, FILE* fp )
 			}
 			fprintf( fp, ")\n" );
 			break;
-			
+		
 		case RX_OP_MATCH_BACKREF:
 			fprintf( fp, "MATCH_BACKREF (slot=%d)\n", (int) ip->from );
 			break;
-			
+		
 		case RX_OP_MATCH_SLSTART:
 			fprintf( fp, "MATCH_SLSTART\n" );
 			break;
-			
+		
 		case RX_OP_MATCH_SLEND:
 			fprintf( fp, "MATCH_SLEND\n" );
 			break;
-			
+		
 		case RX_OP_REPEAT_GREEDY:
 			fprintf( fp, "REPEAT_GREEDY (%u-%u, jump=%u)\n", (unsigned) ip->from, (unsigned) ip->len, (unsigned) ip->start );
 			break;
-			
+		
 		case RX_OP_REPEAT_LAZY:
 			fprintf( fp, "REPEAT_LAZY (%u-%u, jump=%u)\n", (unsigned) ip->from, (unsigned) ip->len, (unsigned) ip->start );
 			break;
-			
+		
 		case RX_OP_JUMP:
 			fprintf( fp, "JUMP (to=%u)\n", (unsigned) ip->start );
 			break;
-			
+		
 		case RX_OP_BACKTRK_JUMP:
 			fprintf( fp, "BACKTRK_JUMP (to=%u)\n", (unsigned) ip->start );
 			break;
-			
+		
 		case RX_OP_CAPTURE_START:
 			fprintf( fp, "CAPTURE_START (slot=%d)\n", (int) ip->from );
 			break;
-			
+		
 		case RX_OP_CAPTURE_END:
 			fprintf( fp, "CAPTURE_END (slot=%d)\n", (int) ip->from );
 			break;
-			
+		
+		}
+		if( prof )
+		{
+			const srx_InstrProfile* p = &prof[ ip - instrs ];
+			fprintf( fp, "        exec=%lu match=%lu fail=%lu backtrack=%lu peak=%lu\n",
+				(unsigned long) p->exec, (unsigned long) p->match, (unsigned long) p->fail,
+				(unsigned long) p->backtrack, (unsigned long) p->peak_states );
 		}
 		if( ip->op == RX_OP_MATCH_DONE )
 			break;
@@ -517,7 +792,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 			c->errcode = RXEUNEXP;
 			c->errpos = s - str;
 			return;
-			
+		
 		case '^':
 			RX_LOG(printf("[^] START (LINE/STRING)\n"));
 			
@@ -526,7 +801,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 			empty = 0;
 			s++;
 			break;
-			
+		
 		case '$':
 			RX_LOG(printf("[$] END (LINE/STRING)\n"));
 			
@@ -535,13 +810,15 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 			empty = 0;
 			s++;
 			break;
-			
+		
 		case '(':
 			RX_LOG(printf("[(] CAPTURE_START\n"));
 			
 			if( c->subexprs_count >= RX_MAX_SUBEXPRS )
 				goto over_limit;
 			
+			/* merge pending characters first, the group starts after them */
+			rxFixLastInstr( c );
 			RX_LAST_SUBEXPR( c ).repeat_start = c->instrs_count;
 			c->subexprs[ c->subexprs_count ].capture_slot = 0;
 			if( c->capture_count < RX_MAX_CAPTURES )
@@ -557,7 +834,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 			c->subexprs_count++;
 			s++;
 			break;
-			
+		
 		case ')':
 			RX_LOG(printf("[)] CAPTURE_END\n"));
 			
@@ -583,7 +860,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 				rxPushInstr( c, RX_OP_CAPTURE_END, 0, c->subexprs[ c->subexprs_count ].capture_slot, 0 );
 			s++;
 			break;
-			
+		
 		case '|':
 			RX_LOG(printf("[|] OR\n"));
 			
@@ -596,7 +873,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 			RX_LAST_SUBEXPR( c ).repeat_start = c->instrs_count;
 			s++;
 			break;
-			
+		
 		case '?':
 			RX_LOG(printf("[?] 0-1 REPEAT / LAZIFIER\n"));
 			if( c->instrs_count && RX_LAST_INSTR( c ).op == RX_OP_REPEAT_GREEDY )
@@ -682,7 +959,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 			RX_LAST_SUBEXPR( c ).repeat_start = c->instrs_count;
 			s++;
 			break;
-			
+		
 		case '.':
 			RX_LOG(printf("DOT\n"));
 			if( c->flags & RCF_DOTALL )
@@ -695,7 +972,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 			RX_LAST_SUBEXPR( c ).repeat_start = c->instrs_count - 1;
 			s++;
 			break;
-			
+		
 		case '\\':
 			RX_LOG(printf("BACKSLASH\n"));
 			RX_SAFE_INCR( s );
@@ -731,7 +1008,7 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 				}
 			}
 			/* fallback to character output */
-			
+		
 		default:
 			RX_LOG(printf("CHAR '%c' (string fallback)\n", *s));
 			
@@ -763,6 +1040,8 @@ static void rxCompile( rxCompiler* c, const rxChar* str, size_t strsize )
 		return;
 	}
 	
+	/* remove useless MATCH_STRING before looking for ending position */
+	rxFixLastInstr( c );
 	/* fix OR jumps */
 	{
 		size_t i;
@@ -793,537 +1072,3506 @@ over_limit:
 	return;
 }
 
-
-static void rxResetCaptures( rxExecute* e )
+static void rxFreeNFA( rxExecute* e, rxNFA* n )
 {
-	int i;
-	for( i = 0; i < RX_MAX_CAPTURES; ++i )
+	if( n->nodes )
 	{
-		e->captures[ i ][0] = RX_NULL_OFFSET;
-		e->captures[ i ][1] = RX_NULL_OFFSET;
+		e->memfn( e->memctx, n->nodes, 0 );
+		n->nodes = NULL;
+	}
+	if( n->sets )
+	{
+		e->memfn( e->memctx, n->sets, 0 );
+		n->sets = NULL;
 	}
 }
 
-static void rxInitExecute( rxExecute* e, srx_MemFunc memfn, void* memctx, rxInstr* instrs, rxChar* chars )
+static uint32_t rxNFAPush( rxExecute* e, rxNFA* n, uint32_t type, uint32_t arg, uint32_t out, uint32_t out1 )
 {
-	e->memfn = memfn;
-	e->memctx = memctx;
-	
-	e->instrs = instrs;
-	e->chars = chars;
-	e->flags = 0;
-	e->capture_count = 0;
-	
-	e->states = NULL;
-	e->states_count = 0;
-	e->states_mem = 0;
-	e->iternum = NULL;
-	e->iternum_count = 0;
-	e->iternum_mem = 0;
-	
-	rxResetCaptures( e );
+	rxNode* nd;
+	if( n->nodes_count >= RX_NFA_MAX_NODES )
+		return RX_NODE_NONE;
+	if( n->nodes_count == n->nodes_mem )
+	{
+		uint32_t ncnt = n->nodes_mem * 2 + 16;
+		n->nodes = (rxNode*) e->memfn( e->memctx, n->nodes, sizeof(*n->nodes) * ncnt );
+		n->nodes_mem = ncnt;
+	}
+	nd = &n->nodes[ n->nodes_count ];
+	nd->type = (uint16_t) type;
+	nd->arg = (uint16_t) arg;
+	nd->out = out;
+	nd->out1 = out1;
+	return n->nodes_count++;
 }
 
-static void rxFreeExecute( rxExecute* e )
+static uint32_t rxNFAPushChar( rxExecute* e, rxNFA* n, const uint32_t* set, uint32_t next )
 {
-	if( e->instrs )
+	uint32_t i;
+	for( i = 0; i < n->sets_count; ++i )
 	{
-		e->memfn( e->memctx, e->instrs, 0 );
-		e->instrs = NULL;
+		if( memcmp( &n->sets[ i * 8 ], set, sizeof(*set) * 8 ) == 0 )
+			break;
 	}
-	if( e->chars )
+	if( i == n->sets_count )
 	{
-		e->memfn( e->memctx, e->chars, 0 );
-		e->chars = NULL;
+		if( n->sets_count == n->sets_mem )
+		{
+			uint32_t ncnt = n->sets_mem * 2 + 16;
+			n->sets = (uint32_t*) e->memfn( e->memctx, n->sets, sizeof(*n->sets) * 8 * ncnt );
+			n->sets_mem = ncnt;
+		}
+		memcpy( &n->sets[ i * 8 ], set, sizeof(*set) * 8 );
+		n->sets_count++;
 	}
-	if( e->states )
+	return rxNFAPush( e, n, RX_NODE_CHAR, i, next, RX_NODE_NONE );
+}
+
+static void rxCharsetBits( rxExecute* e, const rxInstr* op, uint32_t* set )
+{
+	int b;
+	memset( set, 0, sizeof(*set) * 8 );
+	for( b = 0; b < 256; ++b )
 	{
-		e->memfn( e->memctx, e->states, 0 );
-		e->states = NULL;
+		rxChar ch = (rxChar) b;
+		int match = rxMatchCharset( &ch, &e->chars[ op->from ], op->len, ( e->flags & RCF_CASELESS ) != 0 );
+		if( op->op == RX_OP_MATCH_CHARSET_INV )
+			match = !match;
+		if( match )
+			set[ b >> 5 ] |= 1u << ( b & 31 );
 	}
-	if( e->iternum )
+}
+
+static void rxCharBits( rxExecute* e, rxChar c, uint32_t* set )
+{
+	int b;
+	memset( set, 0, sizeof(*set) * 8 );
+	for( b = 0; b < 256; ++b )
 	{
-		e->memfn( e->memctx, e->iternum, 0 );
-		e->iternum = NULL;
+		rxChar ch = (rxChar) b;
+		if( e->flags & RCF_CASELESS ? rxToLower( ch ) == rxToLower( c ) : ch == c )
+			set[ b >> 5 ] |= 1u << ( b & 31 );
 	}
 }
 
-static void rxPushState( rxExecute* e, uint32_t off, uint32_t instr )
+/* returns the end of the program element starting at `i`, 0 if it cannot be decoded */
+static uint32_t rxNFAItemEnd( const rxInstr* instrs, uint32_t i, uint32_t hi )
 {
-	rxState* out;
-	
-	if( e->states_count == e->states_mem )
+	uint32_t j, end = 0;
+	switch( instrs[ i ].op )
 	{
-		size_t ncnt = e->states_mem * 2 + 16;
-		rxState* ns = (rxState*) e->memfn( e->memctx, e->states, sizeof(*ns) * ncnt );
-		e->states = ns;
-		e->states_mem = ncnt;
-	}
+	case RX_OP_MATCH_CHARSET:
+	case RX_OP_MATCH_CHARSET_INV:
+	case RX_OP_MATCH_STRING:
+	case RX_OP_MATCH_BACKREF:
+	case RX_OP_MATCH_SLSTART:
+	case RX_OP_MATCH_SLEND:
+		end = i + 1;
+		break;
 	
-	out = &e->states[ e->states_count++ ];
-	out->off = off & 0x0fffffff;
-	out->flags = 0;
-	out->instr = instr;
-	out->numiters = 0; /* iteration count is only set from stack */
+	case RX_OP_CAPTURE_START:
+		for( j = i + 1; j < hi; ++j )
+		{
+			if( instrs[ j ].op == RX_OP_CAPTURE_END && instrs[ j ].from == instrs[ i ].from )
+			{
+				end = j + 1;
+				break;
+			}
+		}
+		break;
+	
+	case RX_OP_JUMP: /* JUMP <body> REPEAT */
+		j = instrs[ i ].start;
+		if( j < hi && ( instrs[ j ].op == RX_OP_REPEAT_GREEDY || instrs[ j ].op == RX_OP_REPEAT_LAZY ) &&
+			instrs[ j ].start == i + 1 )
+			end = j + 1;
+		break;
+	
+	case RX_OP_BACKTRK_JUMP: /* BACKTRK_JUMP <branch> JUMP(end) <other branches> */
+		j = instrs[ i ].start;
+		if( j > i + 1 && j < hi && instrs[ j - 1 ].op == RX_OP_JUMP )
+			end = instrs[ j - 1 ].start;
+		break;
+	}
+	return end > i && end <= hi ? end : 0;
 }
 
-static void rxPushIterCnt( rxExecute* e, uint32_t it )
+static uint32_t rxNFASeq( rxExecute* e, rxNFA* n, uint32_t lo, uint32_t hi, uint32_t next );
+
+static uint32_t rxNFARepeat( rxExecute* e, rxNFA* n, uint32_t lo, uint32_t hi, const rxInstr* rep, uint32_t next )
 {
-	if( e->iternum_count == e->iternum_mem )
+	uint32_t k, body, tail = next;
+	int lazy = rep->op == RX_OP_REPEAT_LAZY;
+	if( rep->len == RX_MAX_REPEATS )
 	{
-		size_t ncnt = e->iternum_mem * 2 + 16;
-		uint32_t* ni = (uint32_t*) e->memfn( e->memctx, e->iternum, sizeof(*ni) * ncnt );
-		e->iternum = ni;
-		e->iternum_mem = ncnt;
+		tail = rxNFAPush( e, n, RX_NODE_SPLIT, 0, RX_NODE_NONE, RX_NODE_NONE );
+		if( tail == RX_NODE_NONE )
+			return RX_NODE_NONE;
+		body = rxNFASeq( e, n, lo, hi, tail );
+		if( body == RX_NODE_NONE )
+			return RX_NODE_NONE;
+		n->nodes[ tail ].out = lazy ? next : body;
+		n->nodes[ tail ].out1 = lazy ? body : next;
 	}
-	
-	e->iternum[ e->iternum_count++ ] = it;
+	else
+	{
+		/* optional iterations nest: x{0,2} = (x(x)?)? */
+		for( k = rep->from; k < rep->len && tail != RX_NODE_NONE; ++k )
+		{
+			body = rxNFASeq( e, n, lo, hi, tail );
+			if( body == RX_NODE_NONE )
+				return RX_NODE_NONE;
+			tail = rxNFAPush( e, n, RX_NODE_SPLIT, 0, lazy ? next : body, lazy ? body : next );
+		}
+	}
+	for( k = 0; k < rep->from && tail != RX_NODE_NONE; ++k )
+		tail = rxNFASeq( e, n, lo, hi, tail );
+	return tail;
 }
 
-#ifdef NDEBUG
-#  define RX_POP_STATE( e ) ((e)->states_count--)
-#  define RX_POP_ITER_CNT( e ) ((e)->iternum_count--)
-#else
-#  define RX_POP_STATE( e ) assert((e)->states_count-- < 0xffffffff)
-#  define RX_POP_ITER_CNT( e ) assert((e)->iternum_count-- < 0xffffffff)
-#endif
-
-static int rxExecDo( rxExecute* e, const rxChar* str, const rxChar* soff, size_t str_size )
+static uint32_t rxNFAAlt( rxExecute* e, rxNFA* n, uint32_t i, uint32_t end, uint32_t next )
 {
 	const rxInstr* instrs = e->instrs;
-	const rxChar* chars = e->chars;
+	uint32_t j = instrs[ i ].start, first, rest;
+	if( instrs[ i ].op != RX_OP_BACKTRK_JUMP || instrs[ j - 1 ].op != RX_OP_JUMP || instrs[ j - 1 ].start != end )
+		return rxNFASeq( e, n, i, end, next ); /* last branch */
+	first = rxNFASeq( e, n, i + 1, j - 1, next );
+	rest = rxNFAAlt( e, n, j, end, next );
+	if( first == RX_NODE_NONE || rest == RX_NODE_NONE )
+		return RX_NODE_NONE;
+	return rxNFAPush( e, n, RX_NODE_SPLIT, 0, first, rest );
+}
+
+static uint32_t rxNFAItem( rxExecute* e, rxNFA* n, uint32_t i, uint32_t end, uint32_t next )
+{
+	const rxInstr* op = &e->instrs[ i ];
+	uint32_t k, set[ 8 ];
+	if( next == RX_NODE_NONE )
+		return RX_NODE_NONE;
+	switch( op->op )
+	{
+	case RX_OP_MATCH_CHARSET:
+	case RX_OP_MATCH_CHARSET_INV:
+		rxCharsetBits( e, op, set );
+		return rxNFAPushChar( e, n, set, next );
 	
-	rxPushState( e, (uint32_t)( soff - str ), 0 );
+	case RX_OP_MATCH_STRING:
+		for( k = op->len; k > 0 && next != RX_NODE_NONE; --k )
+		{
+			rxCharBits( e, e->chars[ op->from + ( n->reverse ? op->len - k : k - 1 ) ], set );
+			next = rxNFAPushChar( e, n, set, next );
+		}
+		return next;
 	
-	while( e->states_count )
+	/* the string ends swap when matching backwards */
+	case RX_OP_MATCH_SLSTART:
+		if( e->flags & RCF_MULTILINE )
+			return RX_NODE_NONE;
+		return rxNFAPush( e, n, n->reverse ? RX_NODE_EOS : RX_NODE_BOS, 0, next, RX_NODE_NONE );
+	
+	case RX_OP_MATCH_SLEND:
+		if( e->flags & RCF_MULTILINE )
+			return RX_NODE_NONE;
+		return rxNFAPush( e, n, n->reverse ? RX_NODE_BOS : RX_NODE_EOS, 0, next, RX_NODE_NONE );
+	
+	case RX_OP_CAPTURE_START:
+		next = rxNFAPush( e, n, RX_NODE_CAPTURE, op->from * 2 + 1, next, RX_NODE_NONE );
+		next = rxNFASeq( e, n, i + 1, end - 1, next );
+		if( next == RX_NODE_NONE )
+			return RX_NODE_NONE;
+		return rxNFAPush( e, n, RX_NODE_CAPTURE, op->from * 2, next, RX_NODE_NONE );
+	
+	case RX_OP_JUMP:
+		return rxNFARepeat( e, n, i + 1, end - 1, &e->instrs[ end - 1 ], next );
+	
+	case RX_OP_BACKTRK_JUMP:
+		return rxNFAAlt( e, n, i, end, next );
+	}
+	return RX_NODE_NONE; /* backreferences */
+}
+
+/* builds the instructions [lo;hi) backwards (forwards for a reversed NFA), returns the first node */
+static uint32_t rxNFASeq( rxExecute* e, rxNFA* n, uint32_t lo, uint32_t hi, uint32_t next )
+{
+	uint32_t end;
+	if( lo == hi || next == RX_NODE_NONE )
+		return next;
+	end = rxNFAItemEnd( e->instrs, lo, hi );
+	if( !end )
+		return RX_NODE_NONE;
+	if( n->reverse )
+		return rxNFASeq( e, n, end, hi, rxNFAItem( e, n, lo, end, next ) );
+	return rxNFAItem( e, n, lo, end, rxNFASeq( e, n, end, hi, next ) );
+}
+
+static void rxInitNFA( rxNFA* n )
+{
+	n->nodes = NULL;
+	n->nodes_count = 0;
+	n->nodes_mem = 0;
+	n->start = RX_NODE_NONE;
+	n->sets = NULL;
+	n->sets_count = 0;
+	n->sets_mem = 0;
+	n->reverse = 0;
+}
+
+/* adds the program of `e` ending with a match of pattern `id`, returns its first node,
+   RX_NODE_NONE if it is too big or uses backreferences / multiline anchors */
+static uint32_t rxNFAAddProgram( rxExecute* e, rxNFA* n, uint32_t id )
+{
+	uint32_t count = 0;
+	while( e->instrs[ count ].op != RX_OP_MATCH_DONE )
+		count++;
+	return rxNFASeq( e, n, 0, count, rxNFAPush( e, n, RX_NODE_MATCH, id, RX_NODE_NONE, RX_NODE_NONE ) );
+}
+
+/* splits byte classes by each set */
+static void rxNFAClasses( rxNFA* n )
+{
+	uint32_t i;
+	memset( n->classes, 0, sizeof(n->classes) );
+	n->classes_count = 1;
+	for( i = 0; i < n->sets_count; ++i )
 	{
-		int match;
-		rxState* s = &RX_LAST_STATE( e );
-		const rxInstr* op = &instrs[ s->instr ];
-		
-		RX_LOG(printf("[%d]", s->instr));
-		switch( op->op )
+		int b, remap[ 256 ][ 2 ];
+		uint32_t ncount = 0;
+		const uint32_t* set = &n->sets[ i * 8 ];
+		memset( remap, -1, sizeof(remap) );
+		for( b = 0; b < 256; ++b )
 		{
-		case RX_OP_MATCH_DONE:
-			RX_LOG(printf("MATCH_DONE\n"));
-			e->states_count = 0;
-			return 1;
-			
-		case RX_OP_MATCH_CHARSET:
-		case RX_OP_MATCH_CHARSET_INV:
-			RX_LOG(printf("MATCH_CHARSET%s at=%d size=%d: ",op->op == RX_OP_MATCH_CHARSET_INV ? "_INV" : "",s->off,op->len));
-			match = str_size >= (size_t) ( s->off + 1 );
-			if( match )
-			{
-				match = rxMatchCharset( &str[ s->off ], &chars[ op->from ], op->len, ( e->flags & RCF_CASELESS ) != 0 );
-				if( op->op == RX_OP_MATCH_CHARSET_INV )
-					match = !match;
-			}
-			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
-			
-			if( match )
+			int* cls = &remap[ n->classes[ b ] ][ RX_SET_HAS( set, b ) ];
+			if( *cls < 0 )
+				*cls = (int) ncount++;
+			n->classes[ b ] = (uint8_t) *cls;
+		}
+		n->classes_count = ncount;
+	}
+}
+
+/* decodes the program into a NFA (of the reversed language if `reverse` is set),
+   returns 0 if it is too big or uses backreferences / multiline anchors */
+static int rxBuildNFA( rxExecute* e, rxNFA* n, int reverse )
+{
+	rxInitNFA( n );
+	n->reverse = (uint8_t) reverse;
+	n->start = rxNFAAddProgram( e, n, 0 );
+	if( n->start == RX_NODE_NONE )
+	{
+		rxFreeNFA( e, n );
+		return 0;
+	}
+	rxNFAClasses( n );
+	return 1;
+}
+
+/* collects the character nodes reachable from `from` without consuming input in priority order,
+   returns 1 + the lowest pattern index of the reachable regexp ends, 0 if none is reachable */
+static int rxNFAClosure( const rxNFA* n, const uint32_t* from, uint32_t from_count, int at_start, int at_end,
+	uint32_t* marks, uint32_t gen, uint32_t* stack, uint32_t* out, uint32_t* out_count )
+{
+	int matched = 0;
+	uint32_t sp = 0, i;
+	
+	*out_count = 0;
+	for( i = from_count; i > 0; --i )
+		stack[ sp++ ] = from[ i - 1 ];
+	while( sp )
+	{
+		uint32_t id = stack[ --sp ];
+		const rxNode* nd = &n->nodes[ id ];
+		if( marks[ id ] == gen )
+			continue;
+		marks[ id ] = gen;
+		switch( nd->type )
+		{
+		case RX_NODE_CHAR: out[ (*out_count)++ ] = id; break;
+		case RX_NODE_SPLIT: stack[ sp++ ] = nd->out1; stack[ sp++ ] = nd->out; break;
+		case RX_NODE_CAPTURE: stack[ sp++ ] = nd->out; break;
+		case RX_NODE_BOS: if( at_start ) stack[ sp++ ] = nd->out; break;
+		case RX_NODE_EOS: if( at_end ) stack[ sp++ ] = nd->out; break;
+		case RX_NODE_MATCH: if( !matched || nd->arg + 1 < matched ) matched = nd->arg + 1; break;
+		}
+	}
+	return matched;
+}
+
+static int rxCompareU32( const void* a, const void* b )
+{
+	uint32_t x = *(const uint32_t*) a, y = *(const uint32_t*) b;
+	return x < y ? -1 : x > y;
+}
+
+static void rxFreeDFA( rxExecute* e, rxDFA* d )
+{
+	if( d->trans )
+		e->memfn( e->memctx, d->trans, 0 );
+	if( d->accept )
+		e->memfn( e->memctx, d->accept, 0 );
+	if( d->tokens )
+		e->memfn( e->memctx, d->tokens, 0 );
+	e->memfn( e->memctx, d, 0 );
+}
+
+/* subset construction of the search DFA (match anywhere, like srx_MatchExt at offset 0) or the anchored / prefix DFA (RX_DFA_*),
+   a state is the set of nodes following consumed characters (kernel) and whether it is at the string start,
+   returns NULL if there would be more than `max_states` states (a power of 2) */
+static rxDFA* rxBuildDFA( rxExecute* e, const rxNFA* n, int mode, uint32_t max_states )
+{
+	rxDFA* d;
+	uint32_t i, s, c, gen = 0, states_mem = 16, hash_mask = max_states * 2 - 1;
+	uint32_t rep[ 256 ];
+	size_t kernels_count = 0, kernels_mem = 64;
+	uint32_t* kernels = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * kernels_mem );
+	uint32_t* kbeg = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * ( max_states + 1 ) );
+	uint8_t* kbos = (uint8_t*) e->memfn( e->memctx, NULL, max_states );
+	uint32_t* hash = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * ( hash_mask + 1 ) );
+	/* scratch: marks, kernel marks, closure stack, closure list, work list */
+	uint32_t* scratch = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * ( n->nodes_count * 7 + 2 ) );
+	uint32_t* marks = scratch;
+	uint32_t* kmarks = marks + n->nodes_count;
+	uint32_t* stack = kmarks + n->nodes_count;
+	uint32_t* list = stack + n->nodes_count * 3 + 1;
+	uint32_t* work = list + n->nodes_count;
+	
+	d = (rxDFA*) e->memfn( e->memctx, NULL, sizeof(rxDFA) );
+	d->classes_count = n->classes_count;
+	d->trans = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * states_mem * d->classes_count );
+	d->accept = (uint8_t*) e->memfn( e->memctx, NULL, states_mem );
+	d->tokens = mode != RX_DFA_SEARCH ? (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * 2 * states_mem ) : NULL;
+	memcpy( d->classes, n->classes, sizeof(d->classes) );
+	for( i = 0; i < 256; ++i )
+	{
+		d->classes32[ i ] = n->classes[ i ];
+		rep[ n->classes[ 255 - i ] ] = 255 - i;
+	}
+	memset( scratch, 0, sizeof(uint32_t) * n->nodes_count * 2 );
+	memset( hash, 0, sizeof(uint32_t) * ( hash_mask + 1 ) );
+	
+	for( c = 0; c < d->classes_count; ++c )
+		d->trans[ c ] = 0;
+	kbos[ 0 ] = 0;
+	kbos[ 1 ] = 1;
+	kbos[ 2 ] = 0;
+	if( mode != RX_DFA_SEARCH )
+	{
+		/* dead state (empty kernel), start state at string start and elsewhere (the first node, or all nodes for prefixes) */
+		uint32_t h = 2166136261u, klen = mode == RX_DFA_PREFIX ? n->nodes_count : 1;
+		if( klen * 2 > kernels_mem )
+		{
+			kernels_mem = klen * 2;
+			kernels = (uint32_t*) e->memfn( e->memctx, kernels, sizeof(uint32_t) * kernels_mem );
+		}
+		for( i = 0; i < klen; ++i )
+		{
+			kernels[ i ] = kernels[ klen + i ] = mode == RX_DFA_PREFIX ? i : n->start;
+			h = ( h ^ kernels[ i ] ) * 16777619u;
+		}
+		d->accept[ 0 ] = 0;
+		d->tokens[ 0 ] = d->tokens[ 1 ] = 0;
+		kernels_count = klen * 2;
+		kbeg[ 0 ] = kbeg[ 1 ] = 0;
+		kbeg[ 2 ] = klen;
+		kbeg[ 3 ] = klen * 2;
+		hash[ 2166136261u & hash_mask ] = 1;
+		while( hash[ h & hash_mask ] )
+			h++;
+		hash[ h & hash_mask ] = 3;
+	}
+	else
+	{
+		/* match sink, start state (empty kernel at string start) and empty kernel elsewhere */
+		d->accept[ 0 ] = RX_DFA_MATCH | RX_DFA_EOSMATCH;
+		kbeg[ 0 ] = kbeg[ 1 ] = kbeg[ 2 ] = kbeg[ 3 ] = 0;
+		hash[ 2166136261u & hash_mask ] = 3;
+	}
+	d->states_count = 3;
+	d->start_row = d->classes_count;
+	d->mid_row = d->classes_count * 2;
+	
+	for( s = 1; s < d->states_count; ++s )
+	{
+		uint32_t klen = kbeg[ s + 1 ] - kbeg[ s ], list_count;
+		int matched;
+		
+		memcpy( work, kernels + kbeg[ s ], sizeof(uint32_t) * klen );
+		if( mode != RX_DFA_SEARCH )
+		{
+			/* matches are followed to their longest end, so no state is final */
+			d->accept[ s ] = 0;
+			d->tokens[ s * 2 + 1 ] = (uint32_t) rxNFAClosure( n, work, klen, kbos[ s ], 1, marks, ++gen, stack, list, &list_count );
+			d->tokens[ s * 2 ] = (uint32_t) rxNFAClosure( n, work, klen, kbos[ s ], 0, marks, ++gen, stack, list, &list_count );
+			matched = 0;
+		}
+		else
+		{
+			d->accept[ s ] = rxNFAClosure( n, work, klen, kbos[ s ], 1, marks, ++gen, stack, list, &list_count ) ? RX_DFA_EOSMATCH : 0;
+			work[ klen ] = n->start; /* a new match attempt starts at each position */
+			matched = rxNFAClosure( n, work, klen + 1, kbos[ s ], 0, marks, ++gen, stack, list, &list_count );
+			if( matched )
+				d->accept[ s ] |= RX_DFA_MATCH;
+		}
+		
+		for( c = 0; c < d->classes_count; ++c )
+		{
+			uint32_t next_count = 0, h = 2166136261u, *slot, ns;
+			if( matched )
 			{
-				/* replace current single path state with next */
-				s->off++;
-				s->instr++;
+				d->trans[ s * d->classes_count + c ] = 0;
 				continue;
 			}
-			else goto did_not_match;
 			
-		case RX_OP_MATCH_STRING:
-			RX_LOG(printf("MATCH_STRING at=%d size=%d: ",s->off,op->len));
-			match = str_size >= s->off + op->len;
-			if( match )
+			/* kernel of the next state */
+			gen++;
+			for( i = 0; i < list_count; ++i )
 			{
-				if( e->flags & RCF_CASELESS )
-					match = rxMemCaseEq( &str[ s->off ], &chars[ op->from ], op->len );
-				else
-					match = memcmp( &str[ s->off ], &chars[ op->from ], op->len ) == 0;
+				const rxNode* nd = &n->nodes[ list[ i ] ];
+				if( RX_SET_HAS( &n->sets[ nd->arg * 8 ], rep[ c ] ) && kmarks[ nd->out ] != gen )
+				{
+					kmarks[ nd->out ] = gen;
+					work[ next_count++ ] = nd->out;
+				}
 			}
-			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
+			qsort( work, next_count, sizeof(uint32_t), rxCompareU32 );
+			for( i = 0; i < next_count; ++i )
+				h = ( h ^ work[ i ] ) * 16777619u;
 			
-			if( match )
+			/* find or add the state */
+			for( slot = &hash[ h & hash_mask ]; *slot; slot = &hash[ ( ++h ) & hash_mask ] )
 			{
-				/* replace current single path state with next */
-				s->off = ( s->off + op->len ) & 0x0fffffff;
-				s->instr++;
-				continue;
+				ns = *slot - 1;
+				if( !kbos[ ns ] && kbeg[ ns + 1 ] - kbeg[ ns ] == next_count &&
+					memcmp( kernels + kbeg[ ns ], work, sizeof(uint32_t) * next_count ) == 0 )
+					break;
 			}
-			else goto did_not_match;
-			
-		case RX_OP_MATCH_BACKREF:
-			RX_LOG(printf("MATCH_BACKREF at=%d slot=%d: ",s->off,op->from));
-			match = e->captures[ op->from ][0] != RX_NULL_OFFSET
-				&& e->captures[ op->from ][1] != RX_NULL_OFFSET;
+			if( *slot )
+				ns = *slot - 1;
+			else
 			{
-				size_t len = e->captures[ op->from ][1] - e->captures[ op->from ][0];
-				if( match )
+				if( d->states_count == max_states )
 				{
-					match = str_size >= s->off + len;
-					if( match )
-					{
-						if( e->flags & RCF_CASELESS )
-							match = rxMemCaseEq( &str[ s->off ], &str[ e->captures[ op->from ][0] ], len );
-						else
-							match = memcmp( &str[ s->off ], &str[ e->captures[ op->from ][0] ], len ) == 0;
-					}
+					rxFreeDFA( e, d );
+					d = NULL;
+					goto end;
 				}
-				RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
-			
-				if( match )
+				ns = d->states_count++;
+				*slot = ns + 1;
+				if( kernels_count + next_count > kernels_mem )
 				{
-					/* replace current single path state with next */
-					s->off = ( s->off + len ) & 0x0fffffff;
-					s->instr++;
-					continue;
+					kernels_mem = kernels_mem * 2 + next_count;
+					kernels = (uint32_t*) e->memfn( e->memctx, kernels, sizeof(uint32_t) * kernels_mem );
+				}
+				memcpy( kernels + kernels_count, work, sizeof(uint32_t) * next_count );
+				kernels_count += next_count;
+				kbeg[ ns + 1 ] = (uint32_t) kernels_count;
+				kbos[ ns ] = 0;
+				if( ns == states_mem )
+				{
+					states_mem *= 2;
+					d->trans = (uint32_t*) e->memfn( e->memctx, d->trans, sizeof(uint32_t) * states_mem * d->classes_count );
+					d->accept = (uint8_t*) e->memfn( e->memctx, d->accept, states_mem );
+					if( d->tokens )
+						d->tokens = (uint32_t*) e->memfn( e->memctx, d->tokens, sizeof(uint32_t) * 2 * states_mem );
 				}
-				else goto did_not_match;
 			}
-			
-		case RX_OP_MATCH_SLSTART:
-			RX_LOG(printf("MATCH_SLSTART at=%d: ",s->off));
-			match = s->off == 0;
-			if( e->flags & RCF_MULTILINE && s->off < str_size && ( str[ s->off ] == '\n' || str[ s->off ] == '\r' ) )
+			d->trans[ s * d->classes_count + c ] = ns * d->classes_count;
+		}
+	}
+
+end:
+	e->memfn( e->memctx, scratch, 0 );
+	e->memfn( e->memctx, hash, 0 );
+	e->memfn( e->memctx, kbos, 0 );
+	e->memfn( e->memctx, kbeg, 0 );
+	e->memfn( e->memctx, kernels, 0 );
+	return d;
+}
+
+/* returns the search DFA of the context, NULL if the pattern cannot be compiled to one
+   (sticky patterns do not search, so they never get one) */
+static rxDFA* rxGetDFA( rxExecute* e )
+{
+	if( !e->dfa_built && !( e->flags & RCF_STICKY ) )
+	{
+		rxNFA n;
+		e->dfa_built = 1;
+		if( rxBuildNFA( e, &n, 0 ) )
+		{
+			e->dfa = rxBuildDFA( e, &n, RX_DFA_SEARCH, RX_DFA_MAX_STATES );
+			rxFreeNFA( e, &n );
+		}
+	}
+	return e->dfa;
+}
+
+/* returns the DFA of the reversed program in `mode` (RX_DFA_*), NULL if the pattern cannot be compiled to one,
+   it reads the string from the end, so its start row is the string end */
+static rxDFA* rxGetReverseDFA( rxExecute* e, int mode )
+{
+	if( !( e->rdfa_built & ( 1 << mode ) ) )
+	{
+		rxNFA n;
+		e->rdfa_built = (uint8_t)( e->rdfa_built | ( 1 << mode ) );
+		if( rxBuildNFA( e, &n, 1 ) )
+		{
+			e->rdfa[ mode ] = rxBuildDFA( e, &n, mode, RX_DFA_MAX_STATES );
+			rxFreeNFA( e, &n );
+		}
+	}
+	return e->rdfa[ mode ];
+}
+
+static void rxFreeBitNFA( rxExecute* e, rxBitNFA* b )
+{
+	if( b->follow )
+		e->memfn( e->memctx, b->follow, 0 );
+	if( b->precede )
+		e->memfn( e->memctx, b->precede, 0 );
+	e->memfn( e->memctx, b, 0 );
+}
+
+/* bits of the positions among the character nodes `list` */
+static uint64_t rxBitSet( const uint32_t* pos_of, const uint32_t* list, uint32_t count )
+{
+	uint64_t set = 0;
+	uint32_t i;
+	for( i = 0; i < count; ++i )
+		set |= (uint64_t) 1 << pos_of[ list[ i ] ];
+	return set;
+}
+
+/* builds the bit-parallel automaton, returns NULL if the NFA has more than RX_BIT_MAX_POSITIONS character nodes */
+static rxBitNFA* rxBuildBitNFA( rxExecute* e, const rxNFA* n )
+{
+	rxBitNFA* b;
+	uint64_t fol[ RX_BIT_MAX_POSITIONS ];
+	uint32_t i, k, p, gen = 0, count, positions = 0, pos_node[ RX_BIT_MAX_POSITIONS ];
+	/* scratch: marks, position of each node, closure stack, closure list */
+	uint32_t* scratch;
+	uint32_t* marks;
+	uint32_t* pos_of;
+	uint32_t* stack;
+	uint32_t* list;
+	int at_start, at_end;
+	
+	for( i = 0; i < n->nodes_count; ++i )
+	{
+		if( n->nodes[ i ].type != RX_NODE_CHAR )
+			continue;
+		if( positions == RX_BIT_MAX_POSITIONS )
+			return NULL;
+		pos_node[ positions++ ] = i;
+	}
+	scratch = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * ( n->nodes_count * 6 + 2 ) );
+	marks = scratch;
+	pos_of = marks + n->nodes_count;
+	stack = pos_of + n->nodes_count;
+	list = stack + n->nodes_count * 3 + 1;
+	memset( marks, 0, sizeof(uint32_t) * n->nodes_count );
+	for( p = 0; p < positions; ++p )
+		pos_of[ pos_node[ p ] ] = p;
+	
+	b = (rxBitNFA*) e->memfn( e->memctx, NULL, sizeof(rxBitNFA) );
+	memset( b->masks, 0, sizeof(b->masks) );
+	for( p = 0; p < positions; ++p )
+	{
+		const uint32_t* set = &n->sets[ n->nodes[ pos_node[ p ] ].arg * 8 ];
+		for( i = 0; i < 256; ++i )
+		{
+			if( RX_SET_HAS( set, i ) )
+				b->masks[ i ] |= (uint64_t) 1 << p;
+		}
+	}
+	
+	/* a match starts at the first node and ends at the regexp end, characters follow only away from the string ends */
+	b->last[ 0 ] = b->last[ 1 ] = 0;
+	for( at_start = 0; at_start < 2; ++at_start )
+	{
+		for( at_end = 0; at_end < 2; ++at_end )
+		{
+			b->empty[ at_start ][ at_end ] = (uint8_t)( rxNFAClosure( n, &n->start, 1, at_start, at_end, marks, ++gen, stack, list, &count ) != 0 );
+			if( !at_end )
+				b->first[ !at_start ] = rxBitSet( pos_of, list, count );
+		}
+	}
+	for( p = 0; p < positions; ++p )
+	{
+		const uint32_t* next = &n->nodes[ pos_node[ p ] ].out;
+		for( at_end = 0; at_end < 2; ++at_end )
+		{
+			if( rxNFAClosure( n, next, 1, 0, at_end, marks, ++gen, stack, list, &count ) )
+				b->last[ at_end ] |= (uint64_t) 1 << p;
+			if( !at_end )
+				fol[ p ] = rxBitSet( pos_of, list, count );
+		}
+	}
+	
+	/* tables of the unions for each byte of a state */
+	b->tables_count = ( positions + 7 ) / 8;
+	b->follow = (uint64_t*) e->memfn( e->memctx, NULL, sizeof(uint64_t) * 256 * ( b->tables_count ? b->tables_count : 1 ) );
+	b->precede = (uint64_t*) e->memfn( e->memctx, NULL, sizeof(uint64_t) * 256 * ( b->tables_count ? b->tables_count : 1 ) );
+	for( k = 0; k < b->tables_count; ++k )
+	{
+		for( i = 0; i < 256; ++i )
+		{
+			uint64_t f = 0, r = 0;
+			for( p = k * 8; p < k * 8 + 8 && p < positions; ++p )
 			{
-				if( ((size_t)( s->off + 1 )) < str_size && str[ s->off ] == '\r' && str[ s->off + 1 ] == '\n' )
-					s->off++;
-				s->off++;
-				match = 1;
+				if( i >> ( p - k * 8 ) & 1 )
+					f |= fol[ p ];
 			}
-			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
-			
-			if( match )
+			for( p = 0; p < positions; ++p )
 			{
-				s->instr++;
+				if( fol[ p ] >> ( k * 8 ) & i )
+					r |= (uint64_t) 1 << p;
+			}
+			b->follow[ k * 256 + i ] = f;
+			b->precede[ k * 256 + i ] = r;
+		}
+	}
+	e->memfn( e->memctx, scratch, 0 );
+	return b;
+}
+
+/* positions read after (`table` = follow) or before (precede) any position of `state` */
+static uint64_t rxBitNext( const uint64_t* table, uint32_t tables_count, uint64_t state )
+{
+	uint64_t out = 0;
+	uint32_t k;
+	for( k = 0; k < tables_count; ++k, state >>= 8 )
+		out |= table[ k * 256 + ( state & 0xff ) ];
+	return out;
+}
+
+/* end of the first match found by a search from `offset`, like rxDFAFirstEnd, RX_NOPOS if there is none */
+static size_t rxBitFirstEnd( const rxBitNFA* b, const rxChar* str, size_t size, size_t offset )
+{
+	const uint64_t* masks = b->masks;
+	const uint64_t* follow = b->follow;
+	uint64_t state = 0, first = b->first[ 1 ], last = b->last[ 0 ];
+	size_t pos = offset;
+	if( b->empty[ pos == 0 ][ pos == size ] )
+		return pos;
+	if( pos == 0 && pos < size )
+		state = b->first[ 0 ] & masks[ (rxUChar) str[ pos++ ] ];
+	if( b->empty[ 0 ][ 0 ] && pos < size )
+		return pos;
+	if( b->tables_count == 1 )
+	{
+		/* up to 8 positions, one lookup per character */
+		while( pos < size && !( state & last ) )
+			state = ( follow[ state & 0xff ] | first ) & masks[ (rxUChar) str[ pos++ ] ];
+	}
+	else
+	{
+		while( pos < size && !( state & last ) )
+			state = ( rxBitNext( follow, b->tables_count, state ) | first ) & masks[ (rxUChar) str[ pos++ ] ];
+	}
+	if( state & last )
+		return pos;
+	return ( state & b->last[ 1 ] ) || b->empty[ pos == 0 ][ 1 ] ? pos : RX_NOPOS;
+}
+
+/* earliest position at or after `offset` that can start a match reading up to `end`, like rxReversePrefix:
+   the state runs back from `end` over the positions that can read each character and continue to `end` */
+static size_t rxBitFirstStart( const rxBitNFA* b, const rxChar* str, size_t offset, size_t end )
+{
+	uint64_t state = ~(uint64_t) 0;
+	size_t pos = end, beg = end;
+	while( pos > offset )
+	{
+		pos--;
+		state = ( pos + 1 == end ? state : rxBitNext( b->precede, b->tables_count, state ) ) & b->masks[ (rxUChar) str[ pos ] ];
+		if( !state )
+			break;
+		if( state & b->first[ pos != 0 ] )
+			beg = pos;
+	}
+	return beg;
+}
+
+/* returns the bit-parallel automaton of the program, NULL if it is too big or the pattern cannot be compiled to one */
+static rxBitNFA* rxGetBitNFA( rxExecute* e )
+{
+	if( !e->bnfa_built )
+	{
+		rxNFA n;
+		e->bnfa_built = 1;
+		if( rxBuildNFA( e, &n, 0 ) )
+		{
+			e->bnfa = rxBuildBitNFA( e, &n );
+			rxFreeNFA( e, &n );
+		}
+	}
+	return e->bnfa;
+}
+
+/* collects the ends of the paths from `from` that consume no input in priority order: character and regexp end nodes,
+   each with the capture slots set on the way, only the first path to a node counts (later ones have the same future) */
+static void rxOnePassClosure( const rxNFA* n, uint32_t from, int at_start, int at_end,
+	uint32_t* marks, uint32_t gen, uint32_t* stack, uint32_t* out, uint32_t* out_count )
+{
+	uint32_t sp = 0;
+	*out_count = 0;
+	stack[ sp++ ] = from;
+	stack[ sp++ ] = 0;
+	while( sp )
+	{
+		uint32_t mask = stack[ --sp ], id = stack[ --sp ];
+		const rxNode* nd = &n->nodes[ id ];
+		if( marks[ id ] == gen )
+			continue;
+		marks[ id ] = gen;
+		switch( nd->type )
+		{
+		case RX_NODE_CHAR:
+		case RX_NODE_MATCH:
+			out[ (*out_count)++ ] = id;
+			out[ (*out_count)++ ] = mask;
+			break;
+		case RX_NODE_SPLIT:
+			stack[ sp++ ] = nd->out1;
+			stack[ sp++ ] = mask;
+			stack[ sp++ ] = nd->out;
+			stack[ sp++ ] = mask;
+			break;
+		case RX_NODE_CAPTURE:
+			stack[ sp++ ] = nd->out;
+			stack[ sp++ ] = mask | 1u << nd->arg;
+			break;
+		case RX_NODE_BOS:
+		case RX_NODE_EOS:
+			if( nd->type == RX_NODE_BOS ? at_start : at_end )
+			{
+				stack[ sp++ ] = nd->out;
+				stack[ sp++ ] = mask;
+			}
+			break;
+		}
+	}
+}
+
+static void rxFreeOnePass( rxExecute* e, rxOnePass* p )
+{
+	if( p->acts )
+		e->memfn( e->memctx, p->acts, 0 );
+	if( p->caps )
+		e->memfn( e->memctx, p->caps, 0 );
+	if( p->saves )
+		e->memfn( e->memctx, p->saves, 0 );
+	if( p->ends )
+		e->memfn( e->memctx, p->ends, 0 );
+	e->memfn( e->memctx, p, 0 );
+}
+
+/* builds the capture table if the program is one-pass: for each state and character, the first path that can take it
+   is the only one that could, up to the first match on a later path, returns NULL otherwise or if there would be
+   more than `max_states` states (states are the starts and the nodes after characters) */
+static rxOnePass* rxBuildOnePass( rxExecute* e, const rxNFA* n, uint32_t max_states )
+{
+	rxOnePass* p;
+	uint32_t i, j, c, s, gen = 0, out_count, states_mem = 16;
+	uint32_t* marks = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * n->nodes_count );
+	uint32_t* stack = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * ( n->nodes_count * 4 + 2 ) );
+	uint32_t* out = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * n->nodes_count * 2 );
+	uint32_t* node_state = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * n->nodes_count );
+	uint32_t* state_node = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * states_mem );
+	int reps[ 256 ], ok = 1;
+	
+	p = (rxOnePass*) e->memfn( e->memctx, NULL, sizeof(rxOnePass) );
+	p->classes_count = n->classes_count;
+	p->acts = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * states_mem * p->classes_count );
+	p->caps = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * states_mem * p->classes_count );
+	p->saves = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * states_mem * p->classes_count );
+	p->ends = (uint32_t*) e->memfn( e->memctx, NULL, sizeof(uint32_t) * states_mem );
+	memcpy( p->classes, n->classes, sizeof(p->classes) );
+	for( i = 256; i > 0; --i )
+		reps[ n->classes[ i - 1 ] ] = (int)( i - 1 );
+	for( i = 0; i < n->nodes_count; ++i )
+	{
+		marks[ i ] = 0;
+		node_state[ i ] = RX_NODE_NONE;
+	}
+	state_node[ 0 ] = state_node[ 1 ] = n->start;
+	node_state[ n->start ] = 1;
+	p->states_count = 2;
+	
+	for( s = 0; s < p->states_count && ok; ++s )
+	{
+		uint32_t* acts;
+		
+		/* at the string end only regexp ends can be reached */
+		rxOnePassClosure( n, state_node[ s ], s == 0, 1, marks, ++gen, stack, out, &out_count );
+		p->ends[ s ] = 0;
+		for( i = 0; i < out_count; i += 2 )
+		{
+			if( n->nodes[ out[ i ] ].type == RX_NODE_MATCH )
+			{
+				p->ends[ s ] = RX_ONEPASS_MATCH | out[ i + 1 ];
+				break;
+			}
+		}
+		
+		rxOnePassClosure( n, state_node[ s ], s == 0, 0, marks, ++gen, stack, out, &out_count );
+		for( c = 0; c < p->classes_count && ok; ++c )
+		{
+			uint32_t at = s * p->classes_count + c;
+			p->acts[ at ] = p->caps[ at ] = p->saves[ at ] = 0;
+			for( i = 0; i < out_count; i += 2 )
+			{
+				const rxNode* nd = &n->nodes[ out[ i ] ];
+				if( nd->type == RX_NODE_MATCH || RX_SET_HAS( &n->sets[ nd->arg * 8 ], reps[ c ] ) )
+					break;
+			}
+			if( i == out_count )
+				continue;
+			p->caps[ at ] = out[ i + 1 ];
+			if( n->nodes[ out[ i ] ].type == RX_NODE_MATCH )
+			{
+				p->acts[ at ] = RX_ONEPASS_MATCH;
 				continue;
 			}
-			else goto did_not_match;
 			
-		case RX_OP_MATCH_SLEND:
-			RX_LOG(printf("MATCH_SLEND at=%d: ",s->off));
-			match = s->off == str_size;
-			if( e->flags & RCF_MULTILINE && s->off < str_size && ( str[ s->off ] == '\n' || str[ s->off ] == '\r' ) )
+			/* the state after the character */
+			j = n->nodes[ out[ i ] ].out;
+			if( node_state[ j ] == RX_NODE_NONE )
 			{
-				match = 1;
+				if( p->states_count == max_states )
+				{
+					ok = 0;
+					break;
+				}
+				if( p->states_count == states_mem )
+				{
+					states_mem *= 2;
+					state_node = (uint32_t*) e->memfn( e->memctx, state_node, sizeof(uint32_t) * states_mem );
+					p->acts = (uint32_t*) e->memfn( e->memctx, p->acts, sizeof(uint32_t) * states_mem * p->classes_count );
+					p->caps = (uint32_t*) e->memfn( e->memctx, p->caps, sizeof(uint32_t) * states_mem * p->classes_count );
+					p->saves = (uint32_t*) e->memfn( e->memctx, p->saves, sizeof(uint32_t) * states_mem * p->classes_count );
+					p->ends = (uint32_t*) e->memfn( e->memctx, p->ends, sizeof(uint32_t) * states_mem );
+				}
+				node_state[ j ] = p->states_count;
+				state_node[ p->states_count++ ] = j;
 			}
-			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
+			acts = &p->acts[ at ];
+			*acts = node_state[ j ];
 			
-			if( match )
+			/* if the rest fails, the backtracking matcher tries the later paths, which must not take the character */
+			for( i += 2; i < out_count; i += 2 )
 			{
-				s->instr++;
-				continue;
+				const rxNode* nd = &n->nodes[ out[ i ] ];
+				if( nd->type == RX_NODE_MATCH )
+				{
+					*acts |= RX_ONEPASS_SAVE;
+					p->saves[ at ] = out[ i + 1 ];
+					break;
+				}
+				if( RX_SET_HAS( &n->sets[ nd->arg * 8 ], reps[ c ] ) )
+				{
+					ok = 0;
+					break;
+				}
+			}
+		}
+	}
+	
+	e->memfn( e->memctx, marks, 0 );
+	e->memfn( e->memctx, stack, 0 );
+	e->memfn( e->memctx, out, 0 );
+	e->memfn( e->memctx, node_state, 0 );
+	e->memfn( e->memctx, state_node, 0 );
+	if( !ok )
+	{
+		rxFreeOnePass( e, p );
+		return NULL;
+	}
+	return p;
+}
+
+#define RX_LANES 8
+
+/* runs RX_LANES strings through the DFA in lockstep, outputs the final row of each */
+static void rxDFALanes( const rxDFA* d, const rxChar* const* strs, const size_t* sizes, uint32_t* rows )
+{
+	const uint32_t* trans = d->trans;
+	const uint8_t* classes = d->classes;
+	size_t k, minsize = sizes[ 0 ];
+	int l;
+	
+	for( l = 1; l < RX_LANES; ++l )
+	{
+		if( sizes[ l ] < minsize )
+			minsize = sizes[ l ];
+	}
+#if defined(RX_USE_AVX2) && defined(__AVX2__)
+	{
+		/* 8 lanes per vector, byte classes and transitions are gathered (opt-in, gathers are slow on many CPUs) */
+		__m256i r = _mm256_set1_epi32( (int) d->start_row );
+		for( k = 0; k < minsize; ++k )
+		{
+			__m256i ch = _mm256_setr_epi32(
+				(rxUChar) strs[0][k], (rxUChar) strs[1][k], (rxUChar) strs[2][k], (rxUChar) strs[3][k],
+				(rxUChar) strs[4][k], (rxUChar) strs[5][k], (rxUChar) strs[6][k], (rxUChar) strs[7][k] );
+			__m256i cls = _mm256_i32gather_epi32( (const int*) d->classes32, ch, 4 );
+			r = _mm256_i32gather_epi32( (const int*) trans, _mm256_add_epi32( r, cls ), 4 );
+			/* stop once all lanes are in the match sink */
+			if( ( k & 15 ) == 15 && _mm256_testz_si256( r, r ) )
+				break;
+		}
+		_mm256_storeu_si256( (__m256i*) rows, r );
+	}
+#else
+	for( l = 0; l < RX_LANES; ++l )
+		rows[ l ] = d->start_row;
+	for( k = 0; k < minsize; ++k )
+	{
+		/* independent lookups, so the loads of all lanes overlap */
+		for( l = 0; l < RX_LANES; ++l )
+			rows[ l ] = trans[ rows[ l ] + classes[ (rxUChar) strs[ l ][ k ] ] ];
+		if( ( k & 15 ) == 15 && ( rows[0] | rows[1] | rows[2] | rows[3] | rows[4] | rows[5] | rows[6] | rows[7] ) == 0 )
+			break;
+	}
+#endif
+	for( l = 0; l < RX_LANES; ++l )
+	{
+		for( k = minsize; k < sizes[ l ] && rows[ l ]; ++k )
+			rows[ l ] = trans[ rows[ l ] + classes[ (rxUChar) strs[ l ][ k ] ] ];
+	}
+}
+
+/* returns whether the search from `offset` would find a match (stops at the first one) */
+static int rxDFAScan( const rxDFA* d, const rxChar* str, size_t size, size_t offset )
+{
+	uint32_t row = offset ? d->mid_row : d->start_row;
+	const rxChar* s = str + offset;
+	const rxChar* strend = str + size;
+	while( s < strend && row )
+		row = d->trans[ row + d->classes[ (rxUChar) *s++ ] ];
+	return ( d->accept[ row / d->classes_count ] & ( RX_DFA_MATCH | RX_DFA_EOSMATCH ) ) != 0;
+}
+
+/* end of the first match found by a search from `offset` (the earliest end of all matches), RX_NOPOS if there is none */
+static size_t rxDFAFirstEnd( const rxDFA* d, const rxChar* str, size_t size, size_t offset )
+{
+	uint32_t row = offset ? d->mid_row : d->start_row;
+	size_t pos = offset;
+	for( ;; )
+	{
+		uint8_t acc = d->accept[ row / d->classes_count ];
+		if( acc & RX_DFA_MATCH || ( pos == size && acc & RX_DFA_EOSMATCH ) )
+			return pos;
+		if( pos == size )
+			return RX_NOPOS;
+		row = d->trans[ row + d->classes[ (rxUChar) str[ pos++ ] ] ];
+	}
+}
+
+/* earliest start of a match that contains the position `end`: the reversed prefix DFA runs back from there until it dies,
+   each accepting position starts a part of a match that can continue at `end`, returns RX_NOPOS if none is at or after `offset` */
+static size_t rxReversePrefix( const rxDFA* d, const rxChar* str, size_t size, size_t offset, size_t end )
+{
+	uint32_t row = end == size ? d->start_row : d->mid_row;
+	size_t pos = end, beg = RX_NOPOS;
+	while( row )
+	{
+		if( d->tokens[ row / d->classes_count * 2 + ( pos == 0 ) ] )
+			beg = pos;
+		if( pos == offset )
+			break;
+		row = d->trans[ row + d->classes[ (rxUChar) str[ --pos ] ] ];
+	}
+	return beg;
+}
+
+/* first start of a match that ends at the string end: the reversed anchored DFA runs back from the end until it dies,
+   returns RX_NOPOS if none starts at or after `offset` (before the end) */
+static size_t rxReverseFirst( const rxDFA* d, const rxChar* str, size_t size, size_t offset )
+{
+	uint32_t row = d->start_row;
+	size_t pos = size, beg = RX_NOPOS;
+	while( row )
+	{
+		if( pos < size && d->tokens[ row / d->classes_count * 2 + ( pos == 0 ) ] )
+			beg = pos;
+		if( pos == offset )
+			break;
+		row = d->trans[ row + d->classes[ (rxUChar) str[ --pos ] ] ];
+	}
+	return beg;
+}
+
+/* last start of a match: the reversed search DFA runs back from the end until a reversed match ends,
+   returns RX_NOPOS if none starts at or after `offset` (before the end), empty matches at the string start are not seen,
+   the start state must not be a match (an empty match at the end would lead to the match sink right away) */
+static size_t rxReverseLast( const rxDFA* d, const rxChar* str, size_t size, size_t offset )
+{
+	uint32_t row = d->start_row;
+	size_t pos = size;
+	while( pos > offset )
+	{
+		row = d->trans[ row + d->classes[ (rxUChar) str[ --pos ] ] ];
+		if( d->accept[ row / d->classes_count ] & ( pos ? RX_DFA_MATCH : RX_DFA_MATCH | RX_DFA_EOSMATCH ) )
+			return pos;
+	}
+	return RX_NOPOS;
+}
+
+
+/* properties of a part of the program */
+typedef struct rxAnaInfo
+{
+	uint32_t   first[ 8 ]; /* characters that can be matched first */
+	uint32_t   last[ 8 ];  /* characters that can be matched last */
+	uint32_t   all[ 8 ];   /* characters that can be matched anywhere */
+	uint32_t   head[ 8 ];  /* characters that repeats with a variable count can match first at the start of the part */
+	uint32_t   tail[ 8 ];  /* characters that repeats with a variable count can match last at the end of the part */
+	size_t     min_length;
+	size_t     literal_length;
+	size_t     depth;      /* unbounded repeat nesting */
+	uint8_t    anchored_start;
+	uint8_t    anchored_end;
+	uint8_t    ambiguous;  /* contains an alternation with overlapping branches */
+}
+rxAnaInfo;
+
+static int rxSetsOverlap( const uint32_t* a, const uint32_t* b )
+{
+	int i;
+	for( i = 0; i < 8; ++i )
+	{
+		if( a[ i ] & b[ i ] )
+			return 1;
+	}
+	return 0;
+}
+
+static int rxSetContains( const uint32_t* a, const uint32_t* b )
+{
+	int i;
+	for( i = 0; i < 8; ++i )
+	{
+		if( b[ i ] & ~a[ i ] )
+			return 0;
+	}
+	return 1;
+}
+
+static void rxSetAdd( uint32_t* a, const uint32_t* b )
+{
+	int i;
+	for( i = 0; i < 8; ++i )
+		a[ i ] |= b[ i ];
+}
+
+static size_t rxSatMul( size_t a, size_t b )
+{
+	return b && a > (size_t) -1 / b ? (size_t) -1 : a * b;
+}
+
+static size_t rxSatAdd( size_t a, size_t b )
+{
+	return a > (size_t) -1 - b ? (size_t) -1 : a + b;
+}
+
+static void rxAnaCost( srx_Analysis* A, int cost )
+{
+	if( cost > A->cost )
+		A->cost = cost;
+}
+
+/* appends `y` to `x` */
+static void rxAnaConcat( srx_Analysis* A, rxAnaInfo* x, const rxAnaInfo* y )
+{
+	/* overlapping repeats next to each other can split their input in many ways, like a*a* */
+	if( rxSetsOverlap( x->tail, y->head ) )
+		rxAnaCost( A, RX_COST_POLYNOMIAL );
+	x->anchored_start = x->anchored_start || ( x->min_length == 0 && y->anchored_start );
+	x->anchored_end = y->anchored_end || ( y->min_length == 0 && x->anchored_end );
+	if( x->min_length == 0 )
+	{
+		rxSetAdd( x->first, y->first );
+		rxSetAdd( x->head, y->head );
+	}
+	if( y->min_length == 0 )
+		rxSetAdd( x->last, y->last );
+	else
+		memcpy( x->last, y->last, sizeof(x->last) );
+	/* a repeat at the end can still give back characters to the following parts if it can also match them, like .*b.* */
+	if( y->min_length == 0 || rxSetContains( x->tail, y->all ) )
+		rxSetAdd( x->tail, y->tail );
+	else
+		memcpy( x->tail, y->tail, sizeof(x->tail) );
+	rxSetAdd( x->all, y->all );
+	x->min_length = rxSatAdd( x->min_length, y->min_length );
+	x->literal_length = rxSatAdd( x->literal_length, y->literal_length );
+	if( y->depth > x->depth )
+		x->depth = y->depth;
+	x->ambiguous |= y->ambiguous;
+}
+
+static int rxAnaSeq( srx_Analysis* A, rxExecute* e, uint32_t lo, uint32_t hi, rxAnaInfo* out );
+
+static int rxAnaRepeat( srx_Analysis* A, rxExecute* e, uint32_t lo, uint32_t hi, const rxInstr* rep, rxAnaInfo* out )
+{
+	int unbounded = rep->len == RX_MAX_REPEATS;
+	if( !rxAnaSeq( A, e, lo, hi, out ) )
+		return 0;
+	if( rep->len > 1 )
+	{
+		/* the end of one iteration can also be the start of the next one */
+		if( rxSetsOverlap( out->tail, out->first ) || rxSetsOverlap( out->last, out->head ) )
+		{
+			A->flags |= RX_AF_NESTED_REPEAT;
+			rxAnaCost( A, unbounded ? RX_COST_EXPONENTIAL : RX_COST_POLYNOMIAL );
+		}
+		if( out->ambiguous )
+		{
+			A->flags |= RX_AF_AMBIGUOUS_ALT;
+			if( unbounded )
+				rxAnaCost( A, RX_COST_EXPONENTIAL );
+		}
+	}
+	if( unbounded && out->min_length == 0 )
+	{
+		A->flags |= RX_AF_EMPTY_REPEAT;
+		rxAnaCost( A, RX_COST_EXPONENTIAL );
+	}
+	/* a variable count of iterations can split the input in many ways too when repeated, like (a{1,4})* */
+	if( rep->len > rep->from )
+	{
+		rxSetAdd( out->head, out->first );
+		rxSetAdd( out->tail, out->last );
+	}
+	if( unbounded )
+		out->depth++;
+	out->min_length = rxSatMul( out->min_length, rep->from );
+	out->literal_length = rxSatMul( out->literal_length, rep->from );
+	if( rep->from == 0 )
+		out->anchored_start = out->anchored_end = 0;
+	return 1;
+}
+
+static int rxAnaAlt( srx_Analysis* A, rxExecute* e, uint32_t i, uint32_t end, rxAnaInfo* out )
+{
+	const rxInstr* instrs = e->instrs;
+	uint32_t j = instrs[ i ].start;
+	rxAnaInfo rest;
+	if( instrs[ i ].op != RX_OP_BACKTRK_JUMP || instrs[ j - 1 ].op != RX_OP_JUMP || instrs[ j - 1 ].start != end )
+		return rxAnaSeq( A, e, i, end, out ); /* last branch */
+	if( !rxAnaSeq( A, e, i + 1, j - 1, out ) || !rxAnaAlt( A, e, j, end, &rest ) )
+		return 0;
+	out->ambiguous |= rest.ambiguous || rxSetsOverlap( out->first, rest.first );
+	rxSetAdd( out->first, rest.first );
+	rxSetAdd( out->last, rest.last );
+	rxSetAdd( out->all, rest.all );
+	rxSetAdd( out->head, rest.head );
+	rxSetAdd( out->tail, rest.tail );
+	if( rest.min_length < out->min_length )
+		out->min_length = rest.min_length;
+	if( rest.literal_length < out->literal_length )
+		out->literal_length = rest.literal_length;
+	if( rest.depth > out->depth )
+		out->depth = rest.depth;
+	out->anchored_start = out->anchored_start && rest.anchored_start;
+	out->anchored_end = out->anchored_end && rest.anchored_end;
+	return 1;
+}
+
+static int rxAnaItem( srx_Analysis* A, rxExecute* e, uint32_t i, uint32_t end, rxAnaInfo* out )
+{
+	const rxInstr* op = &e->instrs[ i ];
+	uint32_t k, set[ 8 ];
+	memset( out, 0, sizeof(*out) );
+	switch( op->op )
+	{
+	case RX_OP_MATCH_CHARSET:
+	case RX_OP_MATCH_CHARSET_INV:
+		rxCharsetBits( e, op, out->first );
+		memcpy( out->last, out->first, sizeof(out->last) );
+		memcpy( out->all, out->first, sizeof(out->all) );
+		out->min_length = 1;
+		return 1;
+	
+	case RX_OP_MATCH_STRING:
+		rxCharBits( e, e->chars[ op->from ], out->first );
+		rxCharBits( e, e->chars[ op->from + op->len - 1 ], out->last );
+		for( k = 0; k < op->len; ++k )
+		{
+			rxCharBits( e, e->chars[ op->from + k ], set );
+			rxSetAdd( out->all, set );
+		}
+		out->min_length = out->literal_length = op->len;
+		return 1;
+	
+	case RX_OP_MATCH_BACKREF:
+		/* any characters, possibly none */
+		A->flags |= RX_AF_BACKREF;
+		memset( out->first, 0xff, sizeof(out->first) );
+		memset( out->last, 0xff, sizeof(out->last) );
+		memset( out->all, 0xff, sizeof(out->all) );
+		return 1;
+	
+	case RX_OP_MATCH_SLSTART:
+		if( e->flags & RCF_MULTILINE )
+			A->flags &= ~RX_AF_AUTOMATON;
+		else
+			out->anchored_start = 1;
+		return 1;
+	
+	case RX_OP_MATCH_SLEND:
+		if( e->flags & RCF_MULTILINE )
+			A->flags &= ~RX_AF_AUTOMATON;
+		else
+			out->anchored_end = 1;
+		return 1;
+	
+	case RX_OP_CAPTURE_START:
+		return rxAnaSeq( A, e, i + 1, end - 1, out );
+	
+	case RX_OP_JUMP:
+		return rxAnaRepeat( A, e, i + 1, end - 1, &e->instrs[ end - 1 ], out );
+	
+	case RX_OP_BACKTRK_JUMP:
+		return rxAnaAlt( A, e, i, end, out );
+	}
+	return 0;
+}
+
+/* analyzes the instructions [lo;hi), returns 0 if they cannot be decoded */
+static int rxAnaSeq( srx_Analysis* A, rxExecute* e, uint32_t lo, uint32_t hi, rxAnaInfo* out )
+{
+	rxAnaInfo item;
+	memset( out, 0, sizeof(*out) );
+	while( lo < hi )
+	{
+		uint32_t end = rxNFAItemEnd( e->instrs, lo, hi );
+		if( !end || !rxAnaItem( A, e, lo, end, &item ) )
+			return 0;
+		rxAnaConcat( A, out, &item );
+		lo = end;
+	}
+	return 1;
+}
+
+/* computes the properties of the program and selects the engine */
+static void rxAnalyze( rxExecute* e, srx_Analysis* A )
+{
+	rxAnaInfo info;
+	uint32_t i, count = 0;
+	
+	memset( A, 0, sizeof(*A) );
+	A->flags = RX_AF_AUTOMATON | RX_AF_LITERAL;
+	while( e->instrs[ count ].op != RX_OP_MATCH_DONE )
+	{
+		uint32_t op = e->instrs[ count++ ].op;
+		if( op != RX_OP_MATCH_STRING && op != RX_OP_CAPTURE_START && op != RX_OP_CAPTURE_END )
+			A->flags &= ~RX_AF_LITERAL;
+	}
+	if( !rxAnaSeq( A, e, 0, count, &info ) )
+	{
+		/* unknown structure, assume the worst */
+		A->flags &= ~( RX_AF_AUTOMATON | RX_AF_LITERAL );
+		A->cost = RX_COST_EXPONENTIAL;
+		return;
+	}
+	if( A->flags & RX_AF_BACKREF )
+		A->flags &= ~RX_AF_AUTOMATON;
+	if( info.anchored_start )
+		A->flags |= RX_AF_ANCHORED_START;
+	if( info.anchored_end )
+		A->flags |= RX_AF_ANCHORED_END;
+	/* a leading repeat is retried from every position it could have consumed */
+	if( !info.anchored_start )
+	{
+		for( i = 0; i < 8; ++i )
+		{
+			if( info.head[ i ] )
+				rxAnaCost( A, RX_COST_POLYNOMIAL );
+		}
+	}
+	A->min_length = info.min_length;
+	A->literal_length = info.literal_length;
+	A->repeat_depth = info.depth;
+	
+	/* matches of end-anchored patterns end at the string end, a reversed DFA finds where the first one starts,
+	   other automata locate the first match with DFAs on long inputs (built then, unless the backtracker could take exponential time),
+	   or with a bit-parallel simulation of the automaton when the DFAs outgrow their state limit,
+	   anchored patterns fail quickly at other positions, so the backtracking matcher is fastest on its own */
+	if( !( A->flags & RX_AF_AUTOMATON ) || ( e->flags & ( RCF_STICKY | RCF_LONGEST ) ) )
+		return;
+	if( ( A->flags & RX_AF_ANCHORED_END ) && rxGetReverseDFA( e, RX_DFA_ANCHORED ) )
+		A->engine = RX_ENGINE_REVERSE;
+	else if( !( A->flags & RX_AF_ANCHORED_START ) &&
+		( A->cost != RX_COST_EXPONENTIAL || ( rxGetDFA( e ) && rxGetReverseDFA( e, RX_DFA_PREFIX ) ) ) )
+		A->engine = RX_ENGINE_TWO_PHASE;
+	else if( !( A->flags & RX_AF_ANCHORED_START ) && rxGetBitNFA( e ) )
+		A->engine = RX_ENGINE_BIT_PARALLEL;
+	else if( A->cost == RX_COST_EXPONENTIAL && rxGetDFA( e ) )
+		A->engine = RX_ENGINE_DFA_FILTER;
+}
+
+
+static void rxResetCaptures( rxExecute* e )
+{
+	int i;
+	/* slots past capture_count are never written after initialization */
+	for( i = 0; i < e->capture_count; ++i )
+	{
+		e->captures[ i ][0] = RX_NULL_OFFSET;
+		e->captures[ i ][1] = RX_NULL_OFFSET;
+	}
+}
+
+static void rxInitExecute( rxExecute* e, srx_MemFunc memfn, void* memctx, rxInstr* instrs, rxChar* chars )
+{
+	e->memfn = memfn;
+	e->memctx = memctx;
+	
+	e->instrs = instrs;
+	e->chars = chars;
+	e->flags = 0;
+	e->capture_count = 0;
+	e->pattern = NULL;
+	e->pattern_size = 0;
+	memset( &e->analysis, 0, sizeof(e->analysis) );
+	
+	e->slow_fn = NULL;
+	e->slow_userdata = NULL;
+	e->slow_steps = 0;
+	e->slow_seconds = 0;
+	
+	e->states = NULL;
+	e->states_count = 0;
+	e->states_mem = 0;
+	e->iternum = NULL;
+	e->iternum_count = 0;
+	e->iternum_mem = 0;
+	e->hit_end = 0;
+	memset( &e->stats, 0, sizeof(e->stats) );
+	e->dfa = NULL;
+	e->dfa_built = 0;
+	e->rdfa[ 0 ] = e->rdfa[ 1 ] = e->rdfa[ 2 ] = NULL;
+	e->rdfa_built = 0;
+	e->ldfa = NULL;
+	e->onepass = NULL;
+	e->bnfa = NULL;
+	e->bnfa_built = 0;
+#ifdef RX_PROFILE
+	e->prof = NULL;
+	e->prof_count = 0;
+#endif
+	
+	{
+		int i;
+		for( i = 0; i < RX_MAX_CAPTURES; ++i )
+		{
+			e->captures[ i ][0] = RX_NULL_OFFSET;
+			e->captures[ i ][1] = RX_NULL_OFFSET;
+		}
+	}
+}
+
+static void rxFreeExecute( rxExecute* e )
+{
+	if( e->instrs )
+	{
+		e->memfn( e->memctx, e->instrs, 0 );
+		e->instrs = NULL;
+	}
+	if( e->chars )
+	{
+		e->memfn( e->memctx, e->chars, 0 );
+		e->chars = NULL;
+	}
+	if( e->pattern )
+	{
+		e->memfn( e->memctx, e->pattern, 0 );
+		e->pattern = NULL;
+	}
+	if( e->states )
+	{
+		e->memfn( e->memctx, e->states, 0 );
+		e->states = NULL;
+	}
+	if( e->iternum )
+	{
+		e->memfn( e->memctx, e->iternum, 0 );
+		e->iternum = NULL;
+	}
+	if( e->dfa )
+	{
+		rxFreeDFA( e, e->dfa );
+		e->dfa = NULL;
+	}
+	{
+		int i;
+		for( i = 0; i < 3; ++i )
+		{
+			if( e->rdfa[ i ] )
+			{
+				rxFreeDFA( e, e->rdfa[ i ] );
+				e->rdfa[ i ] = NULL;
+			}
+		}
+	}
+	if( e->ldfa )
+	{
+		rxFreeDFA( e, e->ldfa );
+		e->ldfa = NULL;
+	}
+	if( e->onepass )
+	{
+		rxFreeOnePass( e, e->onepass );
+		e->onepass = NULL;
+	}
+	if( e->bnfa )
+	{
+		rxFreeBitNFA( e, e->bnfa );
+		e->bnfa = NULL;
+	}
+#ifdef RX_PROFILE
+	if( e->prof )
+	{
+		e->memfn( e->memctx, e->prof, 0 );
+		e->prof = NULL;
+	}
+#endif
+}
+
+static void rxPushState( rxExecute* e, rxOffset off, uint32_t instr )
+{
+	rxState* out;
+	
+	if( e->states_count == e->states_mem )
+	{
+		size_t ncnt = e->states_mem * 2 + 16;
+		rxState* ns = (rxState*) e->memfn( e->memctx, e->states, sizeof(*ns) * ncnt );
+		e->states = ns;
+		e->states_mem = ncnt;
+		e->stats.reallocs++;
+	}
+	
+	out = &e->states[ e->states_count++ ];
+	if( e->states_count > e->stats.max_depth )
+		e->stats.max_depth = e->states_count;
+	out->off = off & RX_OFFSET_MASK;
+	out->flags = 0;
+	out->instr = instr;
+	out->numiters = 0; /* iteration count is only set from stack */
+}
+
+static void rxPushIterCnt( rxExecute* e, uint32_t it )
+{
+	if( e->iternum_count == e->iternum_mem )
+	{
+		size_t ncnt = e->iternum_mem * 2 + 16;
+		uint32_t* ni = (uint32_t*) e->memfn( e->memctx, e->iternum, sizeof(*ni) * ncnt );
+		e->iternum = ni;
+		e->iternum_mem = ncnt;
+		e->stats.reallocs++;
+	}
+	
+	e->iternum[ e->iternum_count++ ] = it;
+}
+
+#ifdef NDEBUG
+#  define RX_POP_STATE( e ) ((e)->states_count--)
+#  define RX_POP_ITER_CNT( e ) ((e)->iternum_count--)
+#else
+#  define RX_POP_STATE( e ) assert((e)->states_count-- < 0xffffffff)
+#  define RX_POP_ITER_CNT( e ) assert((e)->iternum_count-- < 0xffffffff)
+#endif
+
+static int rxExecDo( rxExecute* e, const rxChar* str, const rxChar* soff, size_t str_size )
+{
+	const rxInstr* instrs = e->instrs;
+	const rxChar* chars = e->chars;
+	
+	e->stats.starts++;
+	rxPushState( e, (rxOffset)( soff - str ), 0 );
+	
+	while( e->states_count )
+	{
+		int match;
+		rxState* s = &RX_LAST_STATE( e );
+		const rxInstr* op = &instrs[ s->instr ];
+		
+		e->stats.steps++;
+		RX_PROF_EXEC( e, s->instr );
+		RX_LOG(printf("[%d]", s->instr));
+		switch( op->op )
+		{
+		case RX_OP_MATCH_DONE:
+			RX_LOG(printf("MATCH_DONE\n"));
+			e->states_count = 0;
+			return 1;
+		
+		case RX_OP_MATCH_CHARSET:
+		case RX_OP_MATCH_CHARSET_INV:
+			RX_LOG(printf("MATCH_CHARSET%s at=%d size=%d: ",op->op == RX_OP_MATCH_CHARSET_INV ? "_INV" : "",s->off,op->len));
+			match = str_size >= (size_t) ( s->off + 1 );
+			if( match )
+			{
+				match = rxMatchCharset( &str[ s->off ], &chars[ op->from ], op->len, ( e->flags & RCF_CASELESS ) != 0 );
+				if( op->op == RX_OP_MATCH_CHARSET_INV )
+					match = !match;
+			}
+			else e->hit_end = 1;
+			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
+			
+			if( match )
+			{
+				RX_PROF( e, s->instr, match );
+				/* replace current single path state with next */
+				s->off++;
+				s->instr++;
+				continue;
+			}
+			else goto did_not_match;
+		
+		case RX_OP_MATCH_STRING:
+			RX_LOG(printf("MATCH_STRING at=%d size=%d: ",s->off,op->len));
+			match = str_size >= s->off + op->len;
+			if( match )
+			{
+				if( e->flags & RCF_CASELESS )
+					match = rxMemCaseEq( &str[ s->off ], &chars[ op->from ], op->len );
+				else
+					match = memcmp( &str[ s->off ], &chars[ op->from ], op->len ) == 0;
+			}
+			else e->hit_end = 1;
+			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
+			
+			if( match )
+			{
+				RX_PROF( e, s->instr, match );
+				/* replace current single path state with next */
+				s->off = ( s->off + op->len ) & RX_OFFSET_MASK;
+				s->instr++;
+				continue;
+			}
+			else goto did_not_match;
+		
+		case RX_OP_MATCH_BACKREF:
+			RX_LOG(printf("MATCH_BACKREF at=%d slot=%d: ",s->off,op->from));
+			match = e->captures[ op->from ][0] != RX_NULL_OFFSET
+				&& e->captures[ op->from ][1] != RX_NULL_OFFSET;
+			{
+				size_t len = e->captures[ op->from ][1] - e->captures[ op->from ][0];
+				if( match )
+				{
+					match = str_size >= s->off + len;
+					if( match )
+					{
+						if( e->flags & RCF_CASELESS )
+							match = rxMemCaseEq( &str[ s->off ], &str[ e->captures[ op->from ][0] ], len );
+						else
+							match = memcmp( &str[ s->off ], &str[ e->captures[ op->from ][0] ], len ) == 0;
+					}
+					else e->hit_end = 1;
+				}
+				RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
+				
+				if( match )
+				{
+					RX_PROF( e, s->instr, match );
+					/* replace current single path state with next */
+					s->off = ( s->off + len ) & RX_OFFSET_MASK;
+					s->instr++;
+					continue;
+				}
+				else goto did_not_match;
+			}
+		
+		case RX_OP_MATCH_SLSTART:
+			RX_LOG(printf("MATCH_SLSTART at=%d: ",s->off));
+			match = s->off == 0;
+			if( e->flags & RCF_MULTILINE && s->off < str_size && ( str[ s->off ] == '\n' || str[ s->off ] == '\r' ) )
+			{
+				if( ((size_t)( s->off + 1 )) == str_size && str[ s->off ] == '\r' )
+					e->hit_end = 1;
+				if( ((size_t)( s->off + 1 )) < str_size && str[ s->off ] == '\r' && str[ s->off + 1 ] == '\n' )
+					s->off++;
+				s->off++;
+				match = 1;
+			}
+			else if( e->flags & RCF_MULTILINE && s->off == str_size )
+				e->hit_end = 1;
+			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
+			
+			if( match )
+			{
+				RX_PROF( e, s->instr, match );
+				s->instr++;
+				continue;
 			}
 			else goto did_not_match;
+		
+		case RX_OP_MATCH_SLEND:
+			RX_LOG(printf("MATCH_SLEND at=%d: ",s->off));
+			match = s->off == str_size;
+			if( match )
+				e->hit_end = 1;
+			if( e->flags & RCF_MULTILINE && s->off < str_size && ( str[ s->off ] == '\n' || str[ s->off ] == '\r' ) )
+			{
+				match = 1;
+			}
+			RX_LOG(printf("%s\n", match ? "MATCHED" : "FAILED"));
+			
+			if( match )
+			{
+				RX_PROF( e, s->instr, match );
+				s->instr++;
+				continue;
+			}
+			else goto did_not_match;
+		
+		case RX_OP_REPEAT_GREEDY:
+			RX_LOG(printf("REPEAT_GREEDY flags=%d numiters=%d itercount=%d iterssz=%d\n", s->flags, s->numiters, e->iternum_count ? (int) RX_NUM_ITERS(e) : -1, e->iternum_count ));
+			if( s->flags & RX_STATE_BACKTRACKED )
+			{
+				/* backtracking because next match failed, try advancing */
+				if( e->iternum_count && s->numiters + 1 == RX_NUM_ITERS( e ) )
+				{
+					RX_POP_ITER_CNT( e );
+				}
+				if( s->numiters < op->from )
+					goto did_not_match;
+				
+				rxPushState( e, s->off, s->instr + 1 ); /* invalidates 's' */
+			}
+			else
+			{
+				/* try to match one more */
+				s->numiters = RX_NUM_ITERS( e )++;
+				if( s->numiters == op->len )
+					s->flags = RX_STATE_BACKTRACKED;
+				else
+					rxPushState( e, s->off, op->start ); /* invalidates 's' */
+			}
+			continue;
+		
+		case RX_OP_REPEAT_LAZY:
+			RX_LOG(printf("REPEAT_LAZY flags=%d numiters=%d itercount=%d iterssz=%d\n", s->flags, s->numiters, e->iternum_count ? (int) RX_NUM_ITERS(e) : -1, e->iternum_count ));
+			if( s->flags & RX_STATE_BACKTRACKED )
+			{
+				/* backtracking because next match failed, try matching one more of previous */
+				uint32_t numiters = (uint32_t)( s->numiters + 1 );
+				if( s->numiters == op->len )
+					goto did_not_match;
+				
+				rxPushState( e, s->off, op->start ); /* invalidates 's' */
+				rxPushIterCnt( e, numiters );
+			}
+			else
+			{
+				/* try to advance first */
+				s->numiters = RX_NUM_ITERS( e );
+				RX_POP_ITER_CNT( e );
+				if( s->numiters < op->from )
+					s->flags = RX_STATE_BACKTRACKED;
+				else
+					rxPushState( e, s->off, s->instr + 1 ); /* invalidates 's' */
+			}
+			continue;
+		
+		case RX_OP_JUMP:
+			RX_LOG(printf("JUMP to=%d\n", op->start));
+			/* only jumps into repeats start a counter, not alternation exits */
+			if( ( instrs[ op->start ].op == RX_OP_REPEAT_GREEDY || instrs[ op->start ].op == RX_OP_REPEAT_LAZY ) &&
+				instrs[ op->start ].start == s->instr + 1 )
+			{
+				const rxInstr* rep = &instrs[ op->start ];
+				if( op->start == s->instr + 2 && RX_INSTR_IS_CHAR( op + 1 ) )
+				{
+					/* a repeated single character needs no counter or state per iteration: the characters are scanned
+					   at once and this state keeps the count of the current path, one less (greedy) or more (lazy) on backtracking */
+					int lazy = rep->op == RX_OP_REPEAT_LAZY;
+					uint32_t last = lazy ? rep->len : rep->from;
+					size_t avail = str_size - s->off;
+					if( !( s->flags & RX_STATE_BACKTRACKED ) )
+					{
+						size_t want = lazy ? rep->from : rep->len;
+						size_t count = rxScanChars( op + 1, chars, &str[ s->off ], want < avail ? want : avail, ( e->flags & RCF_CASELESS ) != 0 );
+						if( count == avail && count < want )
+							e->hit_end = 1;
+						RX_LOG(printf("REPEAT_CHARS %d-%d scanned=%d\n", rep->from, rep->len, (int) count));
+						if( count < rep->from )
+							goto did_not_match;
+						if( count == last )
+						{
+							RX_PROF( e, s->instr, match );
+							/* fixed count or no other count possible, replace current single path state with next */
+							s->off = ( s->off + count ) & RX_OFFSET_MASK;
+							s->instr = op->start + 1;
+							continue;
+						}
+						s->numiters = (uint32_t) count;
+					}
+					else if( lazy )
+					{
+						if( s->numiters == avail )
+							e->hit_end = 1;
+						if( s->numiters == avail || !rxScanChars( op + 1, chars, &str[ s->off + s->numiters ], 1, ( e->flags & RCF_CASELESS ) != 0 ) )
+							goto did_not_match;
+						s->numiters++;
+					}
+					else
+					{
+						/* give back characters until the string that follows could match */
+						const rxInstr* next = &instrs[ op->start + 1 ];
+						s->numiters--;
+						if( next->op == RX_OP_MATCH_STRING )
+						{
+							rxChar c = rxToLower( chars[ next->from ] );
+							int ic = ( e->flags & RCF_CASELESS ) != 0;
+							while( s->numiters > rep->from && s->numiters + next->len <= avail &&
+								( ic ? rxToLower( str[ s->off + s->numiters ] ) != c : str[ s->off + s->numiters ] != chars[ next->from ] ) )
+								s->numiters--;
+						}
+					}
+					RX_PROF( e, s->instr, match );
+					if( s->numiters != last )
+						s->flags = 0; /* more counts to try */
+					rxPushState( e, s->off + s->numiters, op->start + 1 ); /* invalidates 's' */
+					continue;
+				}
+				rxPushIterCnt( e, 0 );
+			}
+			s->instr = op->start;
+			continue;
+		
+		case RX_OP_BACKTRK_JUMP:
+			RX_LOG(printf("BACKTRK_JUMP to=%d\n", op->start));
+			if( s->flags & RX_STATE_BACKTRACKED )
+			{
+				rxPushState( e, s->off, op->start ); /* invalidates 's' */
+			}
+			else
+			{
+				rxPushState( e, s->off, s->instr + 1 ); /* invalidates 's' */
+			}
+			continue;
+		
+		case RX_OP_CAPTURE_START:
+			RX_LOG(printf("CAPTURE_START to=%d off=%d\n", op->from, s->off));
+			s->flags |= RX_STATE_BACKTRACKED; /* no branching */
+			RX_LAST_STATE( e ).numiters = e->captures[ op->from ][0];
+			e->captures[ op->from ][0] = s->off;
+			rxPushState( e, s->off, s->instr + 1 );
+			continue;
+		
+		case RX_OP_CAPTURE_END:
+			RX_LOG(printf("CAPTURE_END to=%d off=%d\n", op->from, s->off));
+			s->flags |= RX_STATE_BACKTRACKED; /* no branching */
+			RX_LAST_STATE( e ).numiters = e->captures[ op->from ][1];
+			e->captures[ op->from ][1] = s->off;
+			rxPushState( e, s->off, s->instr + 1 );
+			continue;
+		}
+		
+did_not_match:
+		RX_PROF( e, op - instrs, fail );
+		/* backtrack until last untraversed branching op, fail if none found */
+		for(;;)
+		{
+			RX_POP_STATE( e );
+			
+			s = &e->states[ e->states_count ];
+			op = &instrs[ s->instr ];
+			
+			/* restore the counter to its value before the repeat op was reached
+			   (none if it was reached from the initial jump) */
+			if( op->op == RX_OP_REPEAT_LAZY && s->numiters != op->len && e->iternum_count )
+			{
+				RX_POP_ITER_CNT( e );
+			}
+			if( ( op->op == RX_OP_REPEAT_GREEDY || op->op == RX_OP_REPEAT_LAZY ) && s->numiters )
+			{
+				rxPushIterCnt( e, (uint32_t) s->numiters );
+			}
+			if( op->op == RX_OP_CAPTURE_START )
+			{
+				e->captures[ op->from ][0] = s->numiters;
+			}
+			if( op->op == RX_OP_CAPTURE_END )
+			{
+				e->captures[ op->from ][1] = s->numiters;
+			}
 			
+			if( e->states_count == 0 || !( e->states[ e->states_count - 1 ].flags & RX_STATE_BACKTRACKED ) )
+				break;
+		}
+		if( e->states_count == 0 )
+		{
+			/* backtracked to the beginning, no matches found */
+			break;
+		}
+		e->states[ e->states_count - 1 ].flags |= RX_STATE_BACKTRACKED;
+		e->stats.backtracks++;
+		RX_PROF( e, e->states[ e->states_count - 1 ].instr, backtrack );
+	}
+	
+	assert( e->states_count == 0 );
+	return 0;
+}
+
+
+static int rxParseMods( rxCompiler* c, const rxChar* mods )
+{
+	const rxChar* modbegin = mods;
+	while( *mods )
+	{
+		switch( *mods )
+		{
+		case 'm': c->flags |= RCF_MULTILINE; break;
+		case 'i': c->flags |= RCF_CASELESS; break;
+		case 's': c->flags |= RCF_DOTALL; break;
+		case 'y': c->flags |= RCF_STICKY; break;
+		case 'l': c->flags |= RCF_LONGEST; break;
+		default:
+			c->errcode = RXEINMOD;
+			c->errpos = (int)( mods - modbegin );
+			return 0;
+		}
+		mods++;
+	}
+	return 1;
+}
+
+/* takes ownership of the compiled program */
+static srx_Context* rxCreateFromCompiler( rxCompiler* c, const rxChar* str, size_t strsize )
+{
+	srx_Context* R = (rxExecute*) c->memfn( c->memctx, NULL, sizeof(rxExecute) );
+	rxInitExecute( R, c->memfn, c->memctx, c->instrs, c->chars );
+	R->flags = c->flags;
+	R->capture_count = c->capture_count;
+#ifdef RX_PROFILE
+	R->prof_count = c->instrs_count;
+	R->prof = (srx_InstrProfile*) c->memfn( c->memctx, NULL, sizeof(srx_InstrProfile) * c->instrs_count );
+	memset( R->prof, 0, sizeof(srx_InstrProfile) * c->instrs_count );
+#endif
+	R->pattern = (rxChar*) c->memfn( c->memctx, NULL, sizeof(rxChar) * ( strsize + 1 ) );
+	if( strsize )
+		memcpy( R->pattern, str, sizeof(rxChar) * strsize );
+	R->pattern[ strsize ] = 0;
+	R->pattern_size = strsize;
+	rxAnalyze( R, &R->analysis );
+	/* transfer ownership of program data */
+	c->instrs = NULL;
+	c->chars = NULL;
+	
+	if( R->flags & RCF_LONGEST )
+	{
+		rxNFA n;
+		if( rxBuildNFA( R, &n, 0 ) )
+		{
+			R->ldfa = rxBuildDFA( R, &n, RX_DFA_ANCHORED, RX_LEX_MAX_STATES );
+			rxFreeNFA( R, &n );
+		}
+		if( !R->ldfa )
+		{
+			srx_Destroy( R );
+			c->errcode = RXEAUTO;
+			c->errpos = 0;
+			return NULL;
+		}
+		/* the search DFA only rejects inputs, it is not required */
+		rxGetDFA( R );
+		R->analysis.engine = RX_ENGINE_DFA_LONGEST;
+	}
+	else if( ( R->analysis.flags & RX_AF_AUTOMATON ) && !( R->analysis.flags & RX_AF_EMPTY_REPEAT ) )
+	{
+		/* the backtracking matcher handles empty iterations differently from the NFA */
+		rxNFA n;
+		if( rxBuildNFA( R, &n, 0 ) )
+		{
+			R->onepass = rxBuildOnePass( R, &n, RX_DFA_MAX_STATES );
+			rxFreeNFA( R, &n );
+		}
+		if( R->onepass )
+			R->analysis.flags |= RX_AF_ONE_PASS;
+	}
+	
+	RX_LOG(srx_DumpToStdout( R ));
+	return R;
+}
+
+srx_Context* srx_CreateExt( const rxChar* str, size_t strsize, const rxChar* mods, int* errnpos, srx_MemFunc memfn, void* memctx )
+{
+	rxCompiler c;
+	srx_Context* R = NULL;
+	
+	if( !memfn )
+		memfn = srx_DefaultMemFunc;
+	
+	rxInitCompiler( &c, memfn, memctx );
+	
+	if( mods && !rxParseMods( &c, mods ) )
+		goto fail;
+	
+	rxCompile( &c, str, strsize );
+	if( c.errcode != RXSUCCESS )
+		goto fail;
+	
+	R = rxCreateFromCompiler( &c, str, strsize );
+	
+fail:
+	if( errnpos )
+	{
+		errnpos[0] = c.errcode;
+		errnpos[1] = c.errpos;
+	}
+	rxFreeCompiler( &c );
+	return R;
+}
+
+/* returns the index of the first instruction with out-of-range arguments, -1 if there are none */
+static int rxCheckProgram( const srx_Program* P )
+{
+	size_t i;
+	if( P->capture_count < 1 || P->capture_count > RX_MAX_CAPTURES )
+		return 0;
+	if( P->instrs_count < 3 || P->instrs_count >= RX_NULL_INSTROFF ||
+		P->instrs[ 0 ].op != RX_OP_CAPTURE_START || P->instrs[ 0 ].from != 0 )
+		return 0;
+	for( i = 0; i < P->instrs_count; ++i )
+	{
+		const srx_Instr* I = &P->instrs[ i ];
+		switch( I->op )
+		{
+		case RX_OP_MATCH_DONE:
+			if( i != P->instrs_count - 1 )
+				return (int) i;
+			break;
+		case RX_OP_MATCH_CHARSET:
+		case RX_OP_MATCH_CHARSET_INV:
+			if( I->len % 2 )
+				return (int) i;
+			/* pass thru */
+		case RX_OP_MATCH_STRING:
+			if( I->from > P->chars_count || I->len > P->chars_count - I->from )
+				return (int) i;
+			break;
+		case RX_OP_MATCH_BACKREF:
+			if( I->from < 1 || I->from >= (unsigned) P->capture_count )
+				return (int) i;
+			break;
+		case RX_OP_MATCH_SLSTART:
+		case RX_OP_MATCH_SLEND:
+			break;
 		case RX_OP_REPEAT_GREEDY:
-			RX_LOG(printf("REPEAT_GREEDY flags=%d numiters=%d itercount=%d iterssz=%d\n", s->flags, s->numiters, e->iternum_count ? (int) RX_NUM_ITERS(e) : -1, e->iternum_count ));
-			if( s->flags & RX_STATE_BACKTRACKED )
+		case RX_OP_REPEAT_LAZY:
+			if( I->from > I->len || I->start >= i )
+				return (int) i;
+			break;
+		case RX_OP_JUMP:
+		case RX_OP_BACKTRK_JUMP:
+			if( I->start >= P->instrs_count )
+				return (int) i;
+			break;
+		case RX_OP_CAPTURE_START:
+		case RX_OP_CAPTURE_END:
+			if( I->from >= (unsigned) P->capture_count )
+				return (int) i;
+			break;
+		default:
+			return (int) i;
+		}
+	}
+	if( P->instrs[ i - 1 ].op != RX_OP_MATCH_DONE ||
+		P->instrs[ i - 2 ].op != RX_OP_CAPTURE_END || P->instrs[ i - 2 ].from != 0 )
+		return (int) i - 1;
+	return -1;
+}
+
+srx_Context* srx_CreateProgram( const srx_Program* P, int* errnpos, srx_MemFunc memfn, void* memctx )
+{
+	rxCompiler c;
+	srx_Context* R = NULL;
+	int bad;
+	
+	if( !memfn )
+		memfn = srx_DefaultMemFunc;
+	
+	rxInitCompiler( &c, memfn, memctx );
+	
+	if( P->mods && !rxParseMods( &c, P->mods ) )
+		goto fail;
+	
+	bad = rxCheckProgram( P );
+	if( bad >= 0 )
+	{
+		c.errcode = RXEPROG;
+		c.errpos = bad;
+		goto fail;
+	}
+	
+	/* copy the program, no parsing needed */
+	{
+		size_t i;
+		c.instrs = (rxInstr*) memfn( memctx, NULL, sizeof(rxInstr) * P->instrs_count );
+		c.instrs_mem = P->instrs_count;
+		for( i = 0; i < P->instrs_count; ++i )
+		{
+			rxInstr* I = &c.instrs[ i ];
+			I->op = P->instrs[ i ].op & 0xf;
+			I->start = P->instrs[ i ].start & 0x0fffffff;
+			I->from = (uint32_t) P->instrs[ i ].from;
+			I->len = (uint32_t) P->instrs[ i ].len;
+		}
+		c.instrs_count = P->instrs_count;
+		if( P->chars_count )
+			rxPushChars( &c, P->chars, P->chars_count );
+		c.capture_count = (uint8_t) P->capture_count;
+	}
+	
+	R = rxCreateFromCompiler( &c, P->pattern ? P->pattern : "", P->pattern ? P->pattern_size : 0 );
+	
+fail:
+	if( errnpos )
+	{
+		errnpos[0] = c.errcode;
+		errnpos[1] = c.errpos;
+	}
+	rxFreeCompiler( &c );
+	return R;
+}
+
+void srx_Destroy( srx_Context* R )
+{
+	srx_MemFunc memfn = R->memfn;
+	void* memctx = R->memctx;
+	rxFreeExecute( R );
+	memfn( memctx, R, 0 );
+}
+
+void srx_DumpToFile( srx_Context* R, FILE* fp )
+{
+#ifdef RX_PROFILE
+	rxDumpToFile( R->instrs, R->chars, R->prof, fp );
+#else
+	rxDumpToFile( R->instrs, R->chars, NULL, fp );
+#endif
+}
+
+int srx_GetProfile( srx_Context* R, int which, srx_InstrProfile* out )
+{
+#ifdef RX_PROFILE
+	if( which < 0 || (size_t) which >= R->prof_count )
+		return 0;
+	*out = R->prof[ which ];
+	return 1;
+#else
+	(void) R;
+	(void) which;
+	(void) out;
+	return 0;
+#endif
+}
+
+void srx_ResetProfile( srx_Context* R )
+{
+#ifdef RX_PROFILE
+	memset( R->prof, 0, sizeof(srx_InstrProfile) * R->prof_count );
+#else
+	(void) R;
+#endif
+}
+
+void srx_GetStats( srx_Context* R, srx_Stats* out )
+{
+	*out = R->stats;
+}
+
+void srx_ResetStats( srx_Context* R )
+{
+	memset( &R->stats, 0, sizeof(R->stats) );
+}
+
+void srx_Analyze( srx_Context* R, srx_Analysis* out )
+{
+	*out = R->analysis;
+}
+
+const char* srx_EngineName( int engine )
+{
+	static const char* names[] = { "backtrack", "dfa_filter", "dfa_longest", "reverse", "two_phase", "bit_parallel" };
+	if( engine < 0 || (size_t) engine >= sizeof(names) / sizeof(names[0]) )
+		return "unknown";
+	return names[ engine ];
+}
+
+void srx_SetSlowCallback( srx_Context* R, size_t max_steps, double max_seconds, srx_SlowFunc fn, void* userdata )
+{
+	R->slow_fn = fn;
+	R->slow_userdata = userdata;
+	R->slow_steps = max_steps;
+	R->slow_seconds = max_seconds;
+}
+
+typedef struct rxCall
+{
+	size_t     steps;     /* step counter at the start of the call */
+	size_t     max_depth; /* stack depth maximum before the call */
+	double     start;
+}
+rxCall;
+
+/* elapsed wall time in seconds from an arbitrary origin, CPU time where no monotonic clock is available */
+static double rxWallTime( void )
+{
+#if defined(_WIN32)
+	LARGE_INTEGER now, freq;
+	QueryPerformanceCounter( &now );
+	QueryPerformanceFrequency( &freq );
+	return (double) now.QuadPart / (double) freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+#else
+	return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static void rxCallBegin( rxExecute* e, rxCall* call )
+{
+	if( !e->slow_fn )
+		return;
+	call->steps = e->stats.steps;
+	call->max_depth = e->stats.max_depth;
+	e->stats.max_depth = 0; /* measure the peak of this call */
+	call->start = e->slow_seconds > 0 ? rxWallTime() : 0;
+}
+
+/* reports the call if it went over a threshold */
+static void rxCallEnd( rxExecute* e, const rxCall* call, const rxChar* str, size_t size, size_t offset )
+{
+	srx_SlowInfo info;
+	if( !e->slow_fn )
+		return;
+	info.pattern = e->pattern;
+	info.pattern_size = e->pattern_size;
+	info.str = str;
+	info.size = size;
+	info.offset = offset;
+	info.steps = e->stats.steps - call->steps;
+	info.max_depth = e->stats.max_depth;
+	info.seconds = e->slow_seconds > 0 ? rxWallTime() - call->start : 0;
+	if( call->max_depth > e->stats.max_depth )
+		e->stats.max_depth = call->max_depth;
+	if( ( e->slow_steps && info.steps > e->slow_steps ) ||
+		( e->slow_seconds > 0 && info.seconds > e->slow_seconds ) )
+		e->slow_fn( e->slow_userdata, e, &info );
+}
+
+/* leftmost-longest attempt at `pos`: the anchored DFA runs until it dies, the last accepting position is the end */
+static int rxLongestAt( rxExecute* e, const rxChar* str, size_t size, size_t pos )
+{
+	const rxDFA* d = e->ldfa;
+	uint32_t row = pos ? d->mid_row : d->start_row;
+	size_t beg = pos, end = RX_NOPOS;
+	for( ;; )
+	{
+		if( d->tokens[ row / d->classes_count * 2 + ( pos == size ) ] )
+			end = pos;
+		if( row == 0 )
+			break;
+		if( pos == size )
+		{
+			e->hit_end = 1;
+			break;
+		}
+		row = d->trans[ row + d->classes[ (rxUChar) str[ pos++ ] ] ];
+	}
+	e->stats.steps += pos - beg;
+	if( end == RX_NOPOS )
+		return 0;
+	/* automata do not track groups, only the whole match is captured */
+	e->captures[ 0 ][0] = (rxOffset) beg;
+	e->captures[ 0 ][1] = (rxOffset) end;
+	return 1;
+}
+
+static void rxOnePassSet( rxOffset caps[][2], uint32_t slots, size_t pos )
+{
+	int k;
+	for( k = 0; slots; ++k, slots >>= 1 )
+	{
+		if( slots & 1 )
+			caps[ k / 2 ][ k & 1 ] = (rxOffset) pos;
+	}
+}
+
+/* attempt at `pos` of a one-pass program: follows the only path that can match, keeping the captures of the last
+   lower-priority match on the way as the result if the path fails, like rxExecDo (captures are unchanged if there is no match) */
+static int rxOnePassAt( rxExecute* e, const rxChar* str, size_t size, size_t pos )
+{
+	const rxOnePass* p = e->onepass;
+	rxOffset caps[ RX_MAX_CAPTURES ][2], saved[ RX_MAX_CAPTURES ][2];
+	size_t beg = pos, ncaps = sizeof(rxOffset) * 2 * e->capture_count;
+	uint32_t s = pos ? 1 : 0;
+	int has_saved = 0, match = 0;
+	
+	e->stats.starts++;
+	memcpy( caps, e->captures, ncaps );
+	for( ;; )
+	{
+		uint32_t i, act;
+		if( pos == size )
+		{
+			e->hit_end = 1;
+			if( p->ends[ s ] & RX_ONEPASS_MATCH )
+			{
+				rxOnePassSet( caps, p->ends[ s ] & ~RX_ONEPASS_MATCH, pos );
+				match = 1;
+			}
+			break;
+		}
+		i = s * p->classes_count + p->classes[ (rxUChar) str[ pos ] ];
+		act = p->acts[ i ];
+		if( act & RX_ONEPASS_MATCH )
+		{
+			rxOnePassSet( caps, p->caps[ i ], pos );
+			match = 1;
+			break;
+		}
+		if( act & RX_ONEPASS_SAVE )
+		{
+			memcpy( saved, caps, ncaps );
+			rxOnePassSet( saved, p->saves[ i ], pos );
+			has_saved = 1;
+		}
+		if( !( act & RX_ONEPASS_NEXT ) )
+			break;
+		rxOnePassSet( caps, p->caps[ i ], pos );
+		s = act & RX_ONEPASS_NEXT;
+		pos++;
+	}
+	e->stats.steps += pos - beg;
+	if( match )
+		memcpy( e->captures, caps, ncaps );
+	else if( has_saved )
+		memcpy( e->captures, saved, ncaps );
+	return match || has_saved;
+}
+
+/* one match attempt at `s` with the engine of the context semantics */
+static int rxAttempt( rxExecute* e, const rxChar* str, const rxChar* s, size_t size )
+{
+	if( e->flags & RCF_LONGEST )
+		return rxLongestAt( e, str, size, (size_t)( s - str ) );
+	if( e->onepass )
+		return rxOnePassAt( e, str, size, (size_t)( s - str ) );
+	return rxExecDo( e, str, s, size );
+}
+
+/* two-phase search: the search DFA finds where the first match ends and the reversed prefix DFA finds the earliest
+   position a match over that end can start at, no match starts before it, so the backtracker (or the anchored DFA
+   of leftmost-longest contexts) only runs from there,
+   the bit-parallel automaton stands in for both once the DFAs outgrow their state limit,
+   returns RX_NOPOS if there is no match, `offset` if the automata cannot be built */
+static size_t rxFirstStart( rxExecute* e, const rxChar* str, size_t size, size_t offset )
+{
+	const rxDFA* d;
+	const rxDFA* p;
+	size_t end, beg;
+	const rxBitNFA* b;
+	if( e->analysis.engine == RX_ENGINE_BIT_PARALLEL )
+	{
+		if( !( b = rxGetBitNFA( e ) ) )
+			return offset;
+		end = rxBitFirstEnd( b, str, size, offset );
+		return end == RX_NOPOS ? RX_NOPOS : rxBitFirstStart( b, str, offset, end );
+	}
+	d = rxGetDFA( e );
+	p = rxGetReverseDFA( e, RX_DFA_PREFIX );
+	if( !d || !p )
+	{
+		/* the DFAs outgrew their state limit, simulate the automaton instead (leftmost-longest contexts keep their engine) */
+		if( ( e->flags & RCF_LONGEST ) || !rxGetBitNFA( e ) )
+			return offset;
+		e->analysis.engine = RX_ENGINE_BIT_PARALLEL;
+		return rxFirstStart( e, str, size, offset );
+	}
+	end = rxDFAFirstEnd( d, str, size, offset );
+	if( end == RX_NOPOS )
+		return RX_NOPOS;
+	beg = rxReversePrefix( p, str, size, offset, end );
+	return beg != RX_NOPOS ? beg : offset;
+}
+
+static int rxSearch( rxExecute* e, const rxChar* str, size_t size, size_t offset )
+{
+	const rxChar* s = str + offset;
+	const rxChar* strend = str + size;
+	if( e->flags & RCF_STICKY )
+		strend = s < strend ? s + 1 : s;
+	else if( e->analysis.engine == RX_ENGINE_REVERSE ||
+		( ( e->analysis.engine == RX_ENGINE_TWO_PHASE || e->analysis.engine == RX_ENGINE_BIT_PARALLEL ) &&
+		( size - offset >= RX_TWO_PHASE_MIN || e->analysis.cost == RX_COST_EXPONENTIAL ) ) ||
+		( ( e->flags & RCF_LONGEST ) && size - offset >= RX_TWO_PHASE_MIN ) )
+	{
+		/* all attempts before the first start would fail */
+		size_t beg = e->analysis.engine == RX_ENGINE_REVERSE ?
+			rxReverseFirst( e->rdfa[ RX_DFA_ANCHORED ], str, size, offset ) : rxFirstStart( e, str, size, offset );
+		e->stats.prefilter_calls++;
+		if( beg == RX_NOPOS )
+		{
+			e->stats.prefilter_rejects++;
+			e->stats.bytes += size - offset;
+			return 0;
+		}
+		e->stats.prefilter_skipped += beg - offset;
+		s = str + beg;
+	}
+	else if( e->analysis.engine != RX_ENGINE_BACKTRACK && e->dfa )
+	{
+		e->stats.prefilter_calls++;
+		if( !rxDFAScan( e->dfa, str, size, offset ) )
+		{
+			e->stats.prefilter_rejects++;
+			e->stats.bytes += size - offset;
+			return 0;
+		}
+	}
+	while( s < strend )
+	{
+		if( rxAttempt( e, str, s, size ) )
+		{
+			assert( e->captures[ 0 ][0] != RX_NULL_OFFSET );
+			assert( e->captures[ 0 ][1] != RX_NULL_OFFSET );
+			e->stats.bytes += e->captures[ 0 ][1] - offset;
+			return 1;
+		}
+		s++;
+	}
+	e->stats.bytes += size - offset;
+	return 0;
+}
+
+int srx_MatchExt( srx_Context* R, const rxChar* str, size_t size, size_t offset )
+{
+	rxCall call;
+	int match;
+	R->stats.calls++;
+	if( offset > size || size > RX_MAX_OFFSET )
+		return 0;
+	R->str = str;
+	rxResetCaptures( R );
+	rxCallBegin( R, &call );
+	match = rxSearch( R, str, size, offset );
+	rxCallEnd( R, &call, str, size, offset );
+	if( !match )
+		return 0;
+	R->stats.matches++;
+	return 1;
+}
+
+int srx_MatchAt( srx_Context* R, const rxChar* str, size_t size, size_t offset )
+{
+	rxCall call;
+	int match;
+	R->stats.calls++;
+	if( offset > size || size > RX_MAX_OFFSET )
+		return 0;
+	R->str = str;
+	rxResetCaptures( R );
+	rxCallBegin( R, &call );
+	match = rxAttempt( R, str, str + offset, size );
+	R->stats.bytes += match ? R->captures[ 0 ][1] - offset : size - offset;
+	rxCallEnd( R, &call, str, size, offset );
+	if( !match )
+		return 0;
+	R->stats.matches++;
+	return 1;
+}
+
+int srx_MatchLast( srx_Context* R, const rxChar* str, size_t size, size_t offset )
+{
+	rxCall call;
+	const rxDFA* d;
+	size_t pos = size;
+	int match = 0;
+	R->stats.calls++;
+	if( offset > size || size > RX_MAX_OFFSET )
+		return 0;
+	R->str = str;
+	rxResetCaptures( R );
+	rxCallBegin( R, &call );
+	if( R->flags & RCF_STICKY )
+		pos = offset < size ? offset + 1 : offset;
+	else if( ( d = rxGetReverseDFA( R, RX_DFA_SEARCH ) ) != NULL && !( d->accept[ d->start_row / d->classes_count ] & RX_DFA_MATCH ) )
+	{
+		/* skip to the last start, the string start is tried anyway for empty matches there */
+		size_t beg = rxReverseLast( d, str, size, offset );
+		pos = beg != RX_NOPOS ? beg + 1 : ( offset == 0 && size ? 1 : offset );
+	}
+	while( pos > offset && !match )
+		match = rxAttempt( R, str, str + --pos, size );
+	R->stats.bytes += size - pos;
+	rxCallEnd( R, &call, str, size, offset );
+	if( !match )
+		return 0;
+	R->stats.matches++;
+	return 1;
+}
+
+int srx_GetCaptureCount( srx_Context* R )
+{
+	return R->capture_count;
+}
+
+int srx_GetCaptured( srx_Context* R, int which, size_t* pbeg, size_t* pend )
+{
+	if( which < 0 || which >= R->capture_count )
+		return 0;
+	if( R->captures[ which ][0] == RX_NULL_OFFSET ||
+		R->captures[ which ][1] == RX_NULL_OFFSET )
+		return 0;
+	if( pbeg ) *pbeg = R->captures[ which ][0];
+	if( pend ) *pend = R->captures[ which ][1];
+	return 1;
+}
+
+int srx_GetCapturedPtrs( srx_Context* R, int which, const rxChar** pbeg, const rxChar** pend )
+{
+	size_t a, b;
+	if( srx_GetCaptured( R, which, &a, &b ) )
+	{
+		if( pbeg ) *pbeg = R->str + a;
+		if( pend ) *pend = R->str + b;
+		return 1;
+	}
+	return 0;
+}
+
+
+srx_Template* srx_CreateTemplateExt( srx_Context* R, const rxChar* rep, size_t repsize )
+{
+	const rxChar* rp = rep, *repend = rep + repsize;
+	rxTemplate* T = (rxTemplate*) R->memfn( R->memctx, NULL, sizeof(rxTemplate) );
+	T->memfn = R->memfn;
+	T->memctx = R->memctx;
+	/* each character produces at most one part and one character */
+	T->parts = (rxTplPart*) R->memfn( R->memctx, NULL, sizeof(rxTplPart) * ( repsize + 1 ) );
+	T->parts_count = 0;
+	T->chars = (rxChar*) R->memfn( R->memctx, NULL, sizeof(rxChar) * ( repsize + 1 ) );
+	T->chars_count = 0;
+	
+	while( rp < repend )
+	{
+		rxChar rc = *rp;
+		rxTplPart* last = T->parts_count ? &T->parts[ T->parts_count - 1 ] : NULL;
+		if( ( rc == '\\' || rc == '$' ) && rp + 1 < repend )
+		{
+			if( rxIsDigit( rp[1] ) )
+			{
+				rxTplPart* P = &T->parts[ T->parts_count++ ];
+				P->from = 0;
+				P->len = 0;
+				P->slot = rp[1] - '0';
+				rp += 2;
+				continue;
+			}
+			else if( rp[1] == rc )
+			{
+				rp++;
+			}
+		}
+		if( !last || last->slot >= 0 )
+		{
+			last = &T->parts[ T->parts_count++ ];
+			last->from = T->chars_count;
+			last->len = 0;
+			last->slot = -1;
+		}
+		T->chars[ T->chars_count++ ] = *rp++;
+		last->len++;
+	}
+	return T;
+}
+
+void srx_DestroyTemplate( srx_Template* T )
+{
+	srx_MemFunc memfn = T->memfn;
+	void* memctx = T->memctx;
+	memfn( memctx, T->parts, 0 );
+	memfn( memctx, T->chars, 0 );
+	memfn( memctx, T, 0 );
+}
+
+static int rxWriteTemplate( rxExecute* e, const rxTemplate* T, srx_WriteFunc fn, void* userdata )
+{
+	size_t i;
+	for( i = 0; i < T->parts_count; ++i )
+	{
+		const rxTplPart* P = &T->parts[ i ];
+		if( P->slot < 0 )
+		{
+			if( fn( userdata, T->chars + P->from, P->len ) )
+				return 1;
+		}
+		else if( P->slot < e->capture_count &&
+			e->captures[ P->slot ][0] != RX_NULL_OFFSET &&
+			e->captures[ P->slot ][1] != RX_NULL_OFFSET &&
+			e->captures[ P->slot ][1] > e->captures[ P->slot ][0] )
+		{
+			if( fn( userdata, e->str + e->captures[ P->slot ][0], e->captures[ P->slot ][1] - e->captures[ P->slot ][0] ) )
+				return 1;
+		}
+	}
+	return 0;
+}
+
+static void rxGetSpans( rxExecute* e, size_t base, srx_Span* caps )
+{
+	int i;
+	for( i = 0; i < e->capture_count; ++i )
+	{
+		if( e->captures[ i ][0] == RX_NULL_OFFSET || e->captures[ i ][1] == RX_NULL_OFFSET )
+		{
+			caps[ i ].beg = RX_NOPOS;
+			caps[ i ].end = RX_NOPOS;
+		}
+		else
+		{
+			caps[ i ].beg = base + e->captures[ i ][0];
+			caps[ i ].end = base + e->captures[ i ][1];
+		}
+	}
+}
+
+/* output is produced from template T or by callback rfn if T is NULL */
+static size_t rxReplaceRun( rxExecute* e, const rxChar* str, size_t strsize, const rxTemplate* T,
+	srx_ReplaceFunc rfn, void* rfndata, srx_WriteFunc fn, void* userdata )
+{
+	size_t count = 0, from = 0, offset = 0;
+	
+	e->str = str;
+	rxResetCaptures( e );
+	if( strsize <= RX_MAX_OFFSET )
+	{
+		while( rxSearch( e, str, strsize, offset ) )
+		{
+			size_t beg = e->captures[ 0 ][0], end = e->captures[ 0 ][1];
+			count++;
+			e->stats.matches++;
+			if( beg > from && fn( userdata, str + from, beg - from ) )
+				return count;
+			if( T )
+			{
+				if( rxWriteTemplate( e, T, fn, userdata ) )
+					return count;
+			}
+			else
+			{
+				srx_Span caps[ RX_MAX_CAPTURES ];
+				rxGetSpans( e, 0, caps );
+				if( rfn( rfndata, e, caps, e->capture_count, fn, userdata ) )
+				{
+					from = end;
+					break;
+				}
+			}
+			from = end;
+			/* empty matches advance by one character to avoid finding them again */
+			offset = end == beg ? end + 1 : end;
+			rxResetCaptures( e );
+		}
+	}
+	if( strsize > from )
+		fn( userdata, str + from, strsize - from );
+	return count;
+}
+
+static size_t rxReplaceDo( rxExecute* e, const rxChar* str, size_t strsize, const rxTemplate* T,
+	srx_ReplaceFunc rfn, void* rfndata, srx_WriteFunc fn, void* userdata )
+{
+	rxCall call;
+	size_t count;
+	
+	e->stats.calls++;
+	rxCallBegin( e, &call );
+	count = rxReplaceRun( e, str, strsize, T, rfn, rfndata, fn, userdata );
+	rxCallEnd( e, &call, str, strsize, 0 );
+	return count;
+}
+
+typedef struct rxOutBuf
+{
+	rxExecute* e;
+	rxChar*    out;
+	size_t     size;
+	size_t     mem;
+}
+rxOutBuf;
+
+static int rxWriteOutBuf( void* userdata, const rxChar* data, size_t size )
+{
+	rxOutBuf* ob = (rxOutBuf*) userdata;
+	if( ob->mem - ob->size < size )
+	{
+		size_t nsz = ob->mem * 2 + size;
+		ob->out = (rxChar*) ob->e->memfn( ob->e->memctx, ob->out, sizeof(rxChar) * nsz );
+		ob->mem = nsz;
+	}
+	memcpy( ob->out + ob->size, data, sizeof(rxChar) * size );
+	ob->size += size;
+	return 0;
+}
+
+typedef struct rxFixedBuf
+{
+	rxChar*    buf;
+	size_t     bufsize;
+	size_t     size;
+}
+rxFixedBuf;
+
+static int rxWriteFixedBuf( void* userdata, const rxChar* data, size_t size )
+{
+	rxFixedBuf* fb = (rxFixedBuf*) userdata;
+	if( fb->size < fb->bufsize )
+	{
+		size_t avail = fb->bufsize - fb->size;
+		memcpy( fb->buf + fb->size, data, sizeof(rxChar) * ( size < avail ? size : avail ) );
+	}
+	fb->size += size;
+	return 0;
+}
+
+rxChar* srx_ReplaceExt( srx_Context* R, const rxChar* str, size_t strsize, const rxChar* rep, size_t repsize, size_t* outsize )
+{
+	rxOutBuf ob;
+	srx_Template* T = srx_CreateTemplateExt( R, rep, repsize );
+	ob.e = R;
+	ob.out = NULL;
+	ob.size = 0;
+	ob.mem = 0;
+	
+	rxReplaceDo( R, str, strsize, T, NULL, NULL, rxWriteOutBuf, &ob );
+	srx_DestroyTemplate( T );
+	
+	if( outsize )
+		*outsize = ob.size;
+	{
+		rxChar nul[1] = {0};
+		rxWriteOutBuf( &ob, nul, 1 );
+	}
+	return ob.out;
+}
+
+rxChar* srx_ReplaceCbExt( srx_Context* R, const rxChar* str, size_t strsize, srx_ReplaceFunc fn, void* userdata, size_t* outsize )
+{
+	rxOutBuf ob;
+	ob.e = R;
+	ob.out = NULL;
+	ob.size = 0;
+	ob.mem = 0;
+	
+	rxReplaceDo( R, str, strsize, NULL, fn, userdata, rxWriteOutBuf, &ob );
+	
+	if( outsize )
+		*outsize = ob.size;
+	{
+		rxChar nul[1] = {0};
+		rxWriteOutBuf( &ob, nul, 1 );
+	}
+	return ob.out;
+}
+
+size_t srx_ReplaceCbSink( srx_Context* R, const rxChar* str, size_t strsize, srx_ReplaceFunc fn, void* userdata, srx_WriteFunc wfn, void* wdata )
+{
+	return rxReplaceDo( R, str, strsize, NULL, fn, userdata, wfn, wdata );
+}
+
+size_t srx_ReplaceSink( srx_Context* R, const rxChar* str, size_t strsize, const srx_Template* T, srx_WriteFunc fn, void* userdata )
+{
+	return rxReplaceDo( R, str, strsize, T, NULL, NULL, fn, userdata );
+}
+
+size_t srx_ReplaceBuf( srx_Context* R, const rxChar* str, size_t strsize, const srx_Template* T, rxChar* buf, size_t bufsize )
+{
+	rxFixedBuf fb;
+	fb.buf = buf;
+	fb.bufsize = bufsize;
+	fb.size = 0;
+	rxReplaceDo( R, str, strsize, T, NULL, NULL, rxWriteFixedBuf, &fb );
+	if( bufsize )
+		buf[ fb.size < bufsize ? fb.size : bufsize - 1 ] = 0;
+	return fb.size;
+}
+
+void srx_FreeReplaced( srx_Context* R, rxChar* repstr )
+{
+	R->memfn( R->memctx, repstr, 0 );
+}
+
+
+static int rxReportMatch( rxExecute* e, size_t base, srx_MatchFunc fn, void* userdata )
+{
+	srx_Span caps[ RX_MAX_CAPTURES ];
+	rxGetSpans( e, base, caps );
+	return fn( userdata, e, caps, e->capture_count );
+}
+
+typedef struct rxSpanBuf
+{
+	srx_Span* out;
+	size_t    count;
+	size_t    max;
+}
+rxSpanBuf;
+
+static int rxCollectSpans( void* userdata, srx_Context* R, const srx_Span* caps, int count )
+{
+	rxSpanBuf* sb = (rxSpanBuf*) userdata;
+	(void) R;
+	memcpy( sb->out + sb->count * (size_t) count, caps, sizeof(*caps) * (size_t) count );
+	return ++sb->count == sb->max;
+}
+
+static size_t rxFindAll( rxExecute* e, const rxChar* str, size_t size, size_t offset, srx_MatchFunc fn, void* userdata )
+{
+	size_t count = 0;
+	e->stats.calls++;
+	if( offset > size || size > RX_MAX_OFFSET )
+		return 0;
+	e->str = str;
+	rxResetCaptures( e );
+	while( rxSearch( e, str, size, offset ) )
+	{
+		size_t beg = e->captures[ 0 ][0], end = e->captures[ 0 ][1];
+		count++;
+		e->stats.matches++;
+		if( rxReportMatch( e, 0, fn, userdata ) )
+			break;
+		/* empty matches advance by one character to avoid finding them again */
+		offset = end == beg ? end + 1 : end;
+		if( offset >= size )
+			break;
+		/* failed attempts restore captures, only the found match needs to be cleared */
+		rxResetCaptures( e );
+	}
+	return count;
+}
+
+size_t srx_FindAllExt( srx_Context* R, const rxChar* str, size_t size, size_t offset, srx_Span* out, size_t maxmatches )
+{
+	rxSpanBuf sb;
+	if( maxmatches == 0 )
+		return 0;
+	sb.out = out;
+	sb.count = 0;
+	sb.max = maxmatches;
+	return rxFindAll( R, str, size, offset, rxCollectSpans, &sb );
+}
+
+size_t srx_FindAllCb( srx_Context* R, const rxChar* str, size_t size, size_t offset, srx_MatchFunc fn, void* userdata )
+{
+	return rxFindAll( R, str, size, offset, fn, userdata );
+}
+
+typedef struct rxSplitData
+{
+	srx_Span* out;
+	size_t    count;
+	size_t    max;
+	size_t    from;
+	size_t    splits;
+	size_t    maxsplits;
+	int       flags;
+}
+rxSplitData;
+
+static void rxSplitPush( rxSplitData* sd, size_t beg, size_t end )
+{
+	if( sd->count < sd->max )
+	{
+		sd->out[ sd->count ].beg = beg;
+		sd->out[ sd->count ].end = end;
+	}
+	sd->count++;
+}
+
+static int rxSplitMatch( void* userdata, srx_Context* R, const srx_Span* caps, int count )
+{
+	int i;
+	rxSplitData* sd = (rxSplitData*) userdata;
+	(void) R;
+	/* empty delimiters never split */
+	if( caps[0].beg == caps[0].end )
+		return 0;
+	rxSplitPush( sd, sd->from, caps[0].beg );
+	if( sd->flags & RX_SPLIT_CAPTURES )
+	{
+		for( i = 1; i < count; ++i )
+			rxSplitPush( sd, caps[ i ].beg, caps[ i ].end );
+	}
+	sd->from = caps[0].end;
+	return ++sd->splits == sd->maxsplits;
+}
+
+size_t srx_SplitExt( srx_Context* R, const rxChar* str, size_t size, srx_Span* out, size_t maxspans, size_t maxsplits, int flags )
+{
+	rxSplitData sd;
+	sd.out = out;
+	sd.count = 0;
+	sd.max = maxspans;
+	sd.from = 0;
+	sd.splits = 0;
+	sd.maxsplits = maxsplits;
+	sd.flags = flags;
+	rxFindAll( R, str, size, 0, rxSplitMatch, &sd );
+	rxSplitPush( &sd, sd.from, size );
+	return sd.count;
+}
+
+/* adds the counters of a private executor to the context */
+static void rxMergeStats( rxExecute* R, const rxExecute* e )
+{
+	R->stats.calls += e->stats.calls;
+	R->stats.bytes += e->stats.bytes;
+	R->stats.starts += e->stats.starts;
+	R->stats.matches += e->stats.matches;
+	R->stats.backtracks += e->stats.backtracks;
+	R->stats.reallocs += e->stats.reallocs;
+	R->stats.steps += e->stats.steps;
+	R->stats.prefilter_calls += e->stats.prefilter_calls;
+	R->stats.prefilter_rejects += e->stats.prefilter_rejects;
+	R->stats.prefilter_skipped += e->stats.prefilter_skipped;
+	if( e->stats.max_depth > R->stats.max_depth )
+		R->stats.max_depth = e->stats.max_depth;
+}
+
+typedef struct rxChunk
+{
+	rxExecute  e;     /* private runtime data, program is shared with the context */
+	const rxChar* str;
+	size_t     size;
+	size_t     beg;   /* first match start offset of the chunk */
+	size_t     end;   /* end of match start offsets of the chunk */
+	srx_Span*  spans; /* capture ranges of found matches */
+	size_t     count;
+	size_t     mem;
+}
+rxChunk;
+
+#define RX_SPAN_NEXT( sp ) ((sp)->end == (sp)->beg ? (sp)->end + 1 : (sp)->end)
+
+static void rxChunkTask( void* data )
+{
+	rxChunk* C = (rxChunk*) data;
+	rxExecute* e = &C->e;
+	size_t pos = C->beg, ncaps = (size_t) e->capture_count;
+	
+	e->str = C->str;
+	e->stats.bytes += C->end - C->beg;
+	rxResetCaptures( e );
+	while( pos < C->end )
+	{
+		if( !rxExecDo( e, C->str, C->str + pos, C->size ) )
+		{
+			pos++;
+			continue;
+		}
+		if( C->count == C->mem )
+		{
+			size_t ncnt = C->mem * 2 + 16;
+			C->spans = (srx_Span*) e->memfn( e->memctx, C->spans, sizeof(srx_Span) * ncaps * ncnt );
+			C->mem = ncnt;
+		}
+		rxGetSpans( e, 0, C->spans + C->count * ncaps );
+		pos = RX_SPAN_NEXT( C->spans + C->count * ncaps );
+		C->count++;
+		rxResetCaptures( e );
+	}
+}
+
+static int rxReportSpans( rxExecute* e, const srx_Span* caps, srx_MatchFunc fn, void* userdata )
+{
+	int i;
+	for( i = 0; i < e->capture_count; ++i )
+	{
+		e->captures[ i ][0] = caps[ i ].beg == RX_NOPOS ? RX_NULL_OFFSET : (rxOffset) caps[ i ].beg;
+		e->captures[ i ][1] = caps[ i ].end == RX_NOPOS ? RX_NULL_OFFSET : (rxOffset) caps[ i ].end;
+	}
+	return fn( userdata, e, caps, e->capture_count );
+}
+
+size_t srx_FindAllParallel( srx_Context* R, const rxChar* str, size_t size, size_t nchunks,
+	srx_ParallelFunc pfn, void* pdata, srx_MatchFunc fn, void* userdata )
+{
+	size_t i, chunksize, count = 0, pos = 0, ncaps = (size_t) R->capture_count;
+	rxChunk* chunks;
+	void** tasks;
+	int stopped = 0;
+	
+	/* sticky matches have to continue where the previous one ended, chunks cannot be scanned on their own,
+	   leftmost-longest attempts would need the anchored DFA in the chunk tasks */
+	if( R->flags & ( RCF_STICKY | RCF_LONGEST ) )
+		return rxFindAll( R, str, size, 0, fn, userdata );
+	R->stats.calls++;
+	if( size > RX_MAX_OFFSET || size == 0 )
+		return 0;
+	if( nchunks == 0 )
+		nchunks = 1;
+	chunksize = ( size + nchunks - 1 ) / nchunks;
+	nchunks = ( size + chunksize - 1 ) / chunksize;
+	
+	chunks = (rxChunk*) R->memfn( R->memctx, NULL, sizeof(rxChunk) * nchunks );
+	tasks = (void**) R->memfn( R->memctx, NULL, sizeof(void*) * nchunks );
+	for( i = 0; i < nchunks; ++i )
+	{
+		rxChunk* C = &chunks[ i ];
+		rxInitExecute( &C->e, R->memfn, R->memctx, R->instrs, R->chars );
+		C->e.flags = R->flags;
+		C->e.capture_count = R->capture_count;
+		C->str = str;
+		C->size = size;
+		C->beg = i * chunksize;
+		C->end = i + 1 < nchunks ? C->beg + chunksize : size;
+		C->spans = NULL;
+		C->count = 0;
+		C->mem = 0;
+		tasks[ i ] = C;
+	}
+	
+	if( pfn )
+		pfn( pdata, rxChunkTask, tasks, nchunks );
+	else
+	{
+		for( i = 0; i < nchunks; ++i )
+			rxChunkTask( tasks[ i ] );
+	}
+	
+	/* merge in order - each chunk has the matches of a scan from its first offset, a sequential scan
+	   agrees with it from the first offset that the chunk scan has tried as well */
+	R->str = str;
+	for( i = 0; i < nchunks && !stopped; ++i )
+	{
+		rxChunk* C = &chunks[ i ];
+		size_t m = 0;
+		while( pos < C->end )
+		{
+			size_t prevnext;
+			while( m < C->count && C->spans[ m * ncaps ].beg < pos )
+				m++;
+			prevnext = m ? RX_SPAN_NEXT( C->spans + ( m - 1 ) * ncaps ) : C->beg;
+			if( pos >= prevnext )
 			{
-				/* backtracking because next match failed, try advancing */
-				if( e->iternum_count && s->numiters + 1 == RX_NUM_ITERS( e ) )
+				/* in sync, the rest of the chunk is valid */
+				for( ; m < C->count; ++m )
 				{
-					RX_POP_ITER_CNT( e );
+					count++;
+					if( rxReportSpans( R, C->spans + m * ncaps, fn, userdata ) )
+					{
+						stopped = 1;
+						break;
+					}
+					pos = RX_SPAN_NEXT( C->spans + m * ncaps );
 				}
-				if( s->numiters < op->from )
-					goto did_not_match;
-				
-				rxPushState( e, s->off, s->instr + 1 ); /* invalidates 's' */
-			}
-			else
-			{
-				/* try to match one more */
-				s->numiters = RX_NUM_ITERS( e )++;
-				if( s->numiters == op->len )
-					s->flags = RX_STATE_BACKTRACKED;
-				else
-					rxPushState( e, s->off, op->start ); /* invalidates 's' */
-			}
-			continue;
-			
-		case RX_OP_REPEAT_LAZY:
-			RX_LOG(printf("REPEAT_LAZY flags=%d numiters=%d itercount=%d iterssz=%d\n", s->flags, s->numiters, e->iternum_count ? (int) RX_NUM_ITERS(e) : -1, e->iternum_count ));
-			if( s->flags & RX_STATE_BACKTRACKED )
-			{
-				/* backtracking because next match failed, try matching one more of previous */
-				if( s->numiters == op->len )
-					goto did_not_match;
-				
-				rxPushState( e, s->off, op->start ); /* invalidates 's' */
-				rxPushIterCnt( e, s->numiters + 1 );
-			}
-			else
-			{
-				/* try to advance first */
-				s->numiters = RX_NUM_ITERS( e );
-				RX_POP_ITER_CNT( e );
-				if( s->numiters < op->from )
-					s->flags = RX_STATE_BACKTRACKED;
-				else
-					rxPushState( e, s->off, s->instr + 1 ); /* invalidates 's' */
+				if( pos < C->end )
+					pos = C->end;
+				break;
 			}
-			continue;
-			
-		case RX_OP_JUMP:
-			RX_LOG(printf("JUMP to=%d\n", op->start));
-			rxPushIterCnt( e, 0 );
-			s->instr = op->start;
-			continue;
 			
-		case RX_OP_BACKTRK_JUMP:
-			RX_LOG(printf("BACKTRK_JUMP to=%d\n", op->start));
-			if( s->flags & RX_STATE_BACKTRACKED )
+			/* position was skipped by a match of the chunk scan, try it directly */
+			rxResetCaptures( R );
+			if( rxExecDo( R, str, str + pos, size ) )
 			{
-				rxPushState( e, s->off, op->start ); /* invalidates 's' */
+				size_t mbeg = R->captures[ 0 ][0], mend = R->captures[ 0 ][1];
+				count++;
+				if( rxReportMatch( R, 0, fn, userdata ) )
+				{
+					stopped = 1;
+					break;
+				}
+				pos = mend == mbeg ? mend + 1 : mend;
 			}
 			else
-			{
-				rxPushState( e, s->off, s->instr + 1 ); /* invalidates 's' */
-			}
-			continue;
-			
-		case RX_OP_CAPTURE_START:
-			RX_LOG(printf("CAPTURE_START to=%d off=%d\n", op->from, s->off));
-			s->flags |= RX_STATE_BACKTRACKED; /* no branching */
-			RX_LAST_STATE( e ).numiters = e->captures[ op->from ][0];
-			e->captures[ op->from ][0] = s->off;
-			rxPushState( e, s->off, s->instr + 1 );
-			continue;
-			
-		case RX_OP_CAPTURE_END:
-			RX_LOG(printf("CAPTURE_END to=%d off=%d\n", op->from, s->off));
-			s->flags |= RX_STATE_BACKTRACKED; /* no branching */
-			RX_LAST_STATE( e ).numiters = e->captures[ op->from ][1];
-			e->captures[ op->from ][1] = s->off;
-			rxPushState( e, s->off, s->instr + 1 );
-			continue;
+				pos++;
 		}
-		
-did_not_match:
-		/* backtrack until last untraversed branching op, fail if none found */
-		RX_POP_STATE( e );
-		while( e->states_count && e->states[ e->states_count - 1 ].flags & RX_STATE_BACKTRACKED )
+	}
+	
+	for( i = 0; i < nchunks; ++i )
+	{
+		rxChunk* C = &chunks[ i ];
+		if( C->spans )
+			R->memfn( R->memctx, C->spans, 0 );
+		rxMergeStats( R, &C->e );
+		/* program data belongs to the context */
+		C->e.instrs = NULL;
+		C->e.chars = NULL;
+		rxFreeExecute( &C->e );
+	}
+	R->memfn( R->memctx, tasks, 0 );
+	R->memfn( R->memctx, chunks, 0 );
+	R->stats.matches += count;
+	return count;
+}
+
+typedef struct rxBatch
+{
+	rxExecute* e;
+	const rxDFA* dfa; /* set if no captures are needed and the pattern has a DFA */
+	rxExecute  own;   /* private runtime data for parallel tasks */
+	const rxChar* const* strs;
+	const size_t* sizes;
+	size_t     beg;
+	size_t     end;
+	unsigned char* bitmap;
+	srx_Span*  caps;
+	size_t     matched;
+}
+rxBatch;
+
+static void rxBatchLanes( rxBatch* B )
+{
+	const rxDFA* d = B->dfa;
+	size_t i;
+	int l;
+	for( i = B->beg; i < B->end; i += RX_LANES )
+	{
+		const rxChar* strs[ RX_LANES ];
+		size_t sizes[ RX_LANES ];
+		uint32_t rows[ RX_LANES ];
+		int lanes = B->end - i < RX_LANES ? (int)( B->end - i ) : RX_LANES;
+		for( l = 0; l < RX_LANES; ++l )
 		{
-			RX_POP_STATE( e );
-			
-			s = &e->states[ e->states_count ];
-			op = &instrs[ s->instr ];
-			
-			if( op->op == RX_OP_REPEAT_LAZY && e->iternum_count && s->numiters == RX_NUM_ITERS( e ) - 1 )
-			{
-				RX_POP_ITER_CNT( e );
-			}
-			if( op->op == RX_OP_CAPTURE_START )
-			{
-				e->captures[ op->from ][0] = s->numiters;
-			}
-			if( op->op == RX_OP_CAPTURE_END )
+			/* unused lanes repeat the first string */
+			size_t j = l < lanes ? i + (size_t) l : i;
+			strs[ l ] = B->strs[ j ];
+			sizes[ l ] = B->sizes ? B->sizes[ j ] : RX_STRLENGTHFUNC( strs[ l ] );
+		}
+		rxDFALanes( d, strs, sizes, rows );
+		for( l = 0; l < lanes; ++l )
+		{
+			B->e->stats.bytes += sizes[ l ];
+			if( sizes[ l ] <= RX_MAX_OFFSET && d->accept[ rows[ l ] / d->classes_count ] & RX_DFA_EOSMATCH )
 			{
-				e->captures[ op->from ][1] = s->numiters;
+				if( B->bitmap )
+					B->bitmap[ ( i + (size_t) l ) / 8 ] = (unsigned char)( B->bitmap[ ( i + (size_t) l ) / 8 ] | ( 1 << ( ( i + (size_t) l ) % 8 ) ) );
+				B->matched++;
 			}
 		}
-		if( e->states_count == 0 )
+	}
+}
+
+static void rxBatchTask( void* data )
+{
+	rxBatch* B = (rxBatch*) data;
+	rxExecute* e = B->e;
+	size_t i, ncaps = (size_t) e->capture_count;
+	
+	if( B->bitmap )
+		memset( B->bitmap + B->beg / 8, 0, ( B->end - B->beg + 7 ) / 8 );
+	e->stats.calls += B->end - B->beg;
+	if( B->dfa )
+	{
+		rxBatchLanes( B );
+		return;
+	}
+	rxResetCaptures( e );
+	for( i = B->beg; i < B->end; ++i )
+	{
+		const rxChar* str = B->strs[ i ];
+		size_t size = B->sizes ? B->sizes[ i ] : RX_STRLENGTHFUNC( str );
+		/* failed attempts leave captures cleared, so only matches need a reset */
+		int match = size <= RX_MAX_OFFSET && rxSearch( e, str, size, 0 );
+		if( B->caps )
+			rxGetSpans( e, 0, B->caps + i * ncaps );
+		if( match )
 		{
-			/* backtracked to the beginning, no matches found */
-			break;
+			if( B->bitmap )
+				B->bitmap[ i / 8 ] = (unsigned char)( B->bitmap[ i / 8 ] | ( 1 << ( i % 8 ) ) );
+			B->matched++;
+			rxResetCaptures( e );
 		}
-		e->states[ e->states_count - 1 ].flags |= RX_STATE_BACKTRACKED;
+	}
+}
+
+size_t srx_MatchBatch( srx_Context* R, const rxChar* const* strs, const size_t* sizes, size_t count,
+	unsigned char* bitmap, srx_Span* caps )
+{
+	rxBatch B;
+	B.e = R;
+	B.dfa = caps ? NULL : rxGetDFA( R );
+	B.strs = strs;
+	B.sizes = sizes;
+	B.beg = 0;
+	B.end = count;
+	B.bitmap = bitmap;
+	B.caps = caps;
+	B.matched = 0;
+	rxBatchTask( &B );
+	R->stats.matches += B.matched;
+	return B.matched;
+}
+
+size_t srx_MatchBatchParallel( srx_Context* R, const rxChar* const* strs, const size_t* sizes, size_t count,
+	unsigned char* bitmap, srx_Span* caps, size_t ntasks, srx_ParallelFunc pfn, void* pdata )
+{
+	size_t i, tasksize, matched = 0;
+	rxBatch* batches;
+	void** tasks;
+	
+	if( count == 0 )
+		return 0;
+	if( ntasks == 0 )
+		ntasks = 1;
+	if( !caps )
+		rxGetDFA( R ); /* shared by all tasks */
+	/* tasks own whole bitmap bytes */
+	tasksize = ( ( count + ntasks - 1 ) / ntasks + 7 ) & ~(size_t) 7;
+	ntasks = ( count + tasksize - 1 ) / tasksize;
+	
+	batches = (rxBatch*) R->memfn( R->memctx, NULL, sizeof(rxBatch) * ntasks );
+	tasks = (void**) R->memfn( R->memctx, NULL, sizeof(void*) * ntasks );
+	for( i = 0; i < ntasks; ++i )
+	{
+		rxBatch* B = &batches[ i ];
+		rxInitExecute( &B->own, R->memfn, R->memctx, R->instrs, R->chars );
+		B->own.flags = R->flags;
+		B->own.capture_count = R->capture_count;
+		B->own.ldfa = R->ldfa;
+		B->e = &B->own;
+		B->dfa = caps ? NULL : R->dfa;
+		B->strs = strs;
+		B->sizes = sizes;
+		B->beg = i * tasksize;
+		B->end = i + 1 < ntasks ? B->beg + tasksize : count;
+		B->bitmap = bitmap;
+		B->caps = caps;
+		B->matched = 0;
+		tasks[ i ] = B;
 	}
 	
-	assert( e->states_count == 0 );
-	return 0;
+	if( pfn )
+		pfn( pdata, rxBatchTask, tasks, ntasks );
+	else
+	{
+		for( i = 0; i < ntasks; ++i )
+			rxBatchTask( tasks[ i ] );
+	}
+	
+	for( i = 0; i < ntasks; ++i )
+	{
+		rxBatch* B = &batches[ i ];
+		matched += B->matched;
+		B->own.stats.matches += B->matched;
+		rxMergeStats( R, &B->own );
+		/* program data belongs to the context */
+		B->own.instrs = NULL;
+		B->own.chars = NULL;
+		B->own.ldfa = NULL;
+		rxFreeExecute( &B->own );
+	}
+	R->memfn( R->memctx, tasks, 0 );
+	R->memfn( R->memctx, batches, 0 );
+	return matched;
 }
 
 
-srx_Context* srx_CreateExt( const rxChar* str, size_t strsize, const rxChar* mods, int* errnpos, srx_MemFunc memfn, void* memctx )
+srx_Lexer* srx_CreateLexer( const rxChar* const* patterns, const size_t* sizes, size_t count, const rxChar* mods,
+	int* errnpos, srx_MemFunc memfn, void* memctx )
 {
-	rxCompiler c;
-	srx_Context* R = NULL;
+	rxLexer* L = NULL;
+	rxNFA n;
+	size_t i;
+	int err[ 3 ] = { RXSUCCESS, 0, -1 };
 	
 	if( !memfn )
 		memfn = srx_DefaultMemFunc;
 	
-	rxInitCompiler( &c, memfn, memctx );
+	L = (rxLexer*) memfn( memctx, NULL, sizeof(rxLexer) );
+	rxInitExecute( &L->e, memfn, memctx, NULL, NULL );
+	L->dfa = NULL;
+	L->count = count;
+	rxInitNFA( &n );
+	
+	if( count == 0 || count > 0xffff )
+	{
+		err[0] = count ? RXELIMIT : RXEEMPTY;
+		goto fail;
+	}
 	
-	if( mods )
+	/* one NFA, each pattern ends with its own match node */
+	for( i = 0; i < count; ++i )
 	{
-		const rxChar* modbegin = mods;
-		while( *mods )
+		uint32_t first;
+		srx_Context* R = srx_CreateExt( patterns[ i ], sizes ? sizes[ i ] : RX_STRLENGTHFUNC( patterns[ i ] ), mods, err, memfn, memctx );
+		err[2] = (int) i;
+		if( !R )
+			goto fail;
+		first = rxNFAAddProgram( R, &n, (uint32_t) i );
+		srx_Destroy( R );
+		if( first == RX_NODE_NONE )
 		{
-			switch( *mods )
-			{
-			case 'm': c.flags |= RCF_MULTILINE; break;
-			case 'i': c.flags |= RCF_CASELESS; break;
-			case 's': c.flags |= RCF_DOTALL; break;
-			default:
-				c.errcode = RXEINMOD;
-				c.errpos = mods - modbegin;
-				goto fail;
-			}
-			mods++;
+			err[0] = RXEAUTO;
+			err[1] = 0;
+			goto fail;
+		}
+		n.start = i ? rxNFAPush( &L->e, &n, RX_NODE_SPLIT, 0, n.start, first ) : first;
+		if( n.start == RX_NODE_NONE )
+		{
+			err[0] = RXEAUTO;
+			goto fail;
 		}
 	}
+	err[2] = -1;
 	
-	rxCompile( &c, str, strsize );
-	if( c.errcode != RXSUCCESS )
-		goto fail;
-	
-	/* create context */
-	R = (rxExecute*) memfn( memctx, NULL, sizeof(rxExecute) );
-	rxInitExecute( R, memfn, memctx, c.instrs, c.chars );
-	R->flags = c.flags;
-	R->capture_count = c.capture_count;
-	/* transfer ownership of program data */
-	c.instrs = NULL;
-	c.chars = NULL;
-	
-	RX_LOG(srx_DumpToStdout( R ));
+	rxNFAClasses( &n );
+	L->dfa = rxBuildDFA( &L->e, &n, RX_DFA_ANCHORED, RX_LEX_MAX_STATES );
+	if( !L->dfa )
+		err[0] = RXEAUTO;
 	
 fail:
+	rxFreeNFA( &L->e, &n );
 	if( errnpos )
 	{
-		errnpos[0] = c.errcode;
-		errnpos[1] = c.errpos;
+		errnpos[0] = err[0];
+		errnpos[1] = err[1];
+		errnpos[2] = err[2];
 	}
-	rxFreeCompiler( &c );
-	return R;
+	if( err[0] != RXSUCCESS )
+	{
+		srx_DestroyLexer( L );
+		return NULL;
+	}
+	return L;
 }
 
-void srx_Destroy( srx_Context* R )
+void srx_DestroyLexer( srx_Lexer* L )
 {
-	srx_MemFunc memfn = R->memfn;
-	void* memctx = R->memctx;
-	rxFreeExecute( R );
-	memfn( memctx, R, 0 );
+	if( L->dfa )
+		rxFreeDFA( &L->e, L->dfa );
+	rxFreeExecute( &L->e );
+	L->e.memfn( L->e.memctx, L, 0 );
 }
 
-void srx_DumpToFile( srx_Context* R, FILE* fp )
+/* follows the anchored DFA until it dies or the string ends, remembering the last token end */
+static int rxLexerRun( const rxLexer* L, const rxChar* str, size_t size, size_t offset, size_t* pend )
 {
-	rxDumpToFile( R->instrs, R->chars, fp );
+	const rxDFA* d = L->dfa;
+	uint32_t row = offset ? d->mid_row : d->start_row;
+	size_t pos = offset;
+	int id = -1;
+	for( ;; )
+	{
+		uint32_t tok = d->tokens[ row / d->classes_count * 2 + ( pos == size ) ];
+		if( tok )
+		{
+			id = (int) tok - 1;
+			*pend = pos;
+		}
+		if( pos == size || row == 0 )
+			return id;
+		row = d->trans[ row + d->classes[ (rxUChar) str[ pos++ ] ] ];
+	}
 }
 
-int srx_MatchExt( srx_Context* R, const rxChar* str, size_t size, size_t offset )
+int srx_LexerMatch( const srx_Lexer* L, const rxChar* str, size_t size, size_t offset, size_t* pend )
 {
-	const rxChar* strstart = str;
-	const rxChar* strend = str + size;
+	size_t end = offset;
+	int id;
 	if( offset > size )
-		return 0;
-	R->str = strstart;
-	str += offset;
-	rxResetCaptures( R );
-	while( str < strend )
+		return -1;
+	id = rxLexerRun( L, str, size, offset, &end );
+	if( id >= 0 && pend )
+		*pend = end;
+	return id;
+}
+
+int srx_LexerFind( const srx_Lexer* L, const rxChar* str, size_t size, size_t offset, srx_Span* out )
+{
+	size_t pos, end;
+	for( pos = offset; pos < size; ++pos )
 	{
-		if( rxExecDo( R, strstart, str, size ) )
+		int id = rxLexerRun( L, str, size, pos, &end );
+		if( id >= 0 )
 		{
-			assert( R->captures[ 0 ][0] != RX_NULL_OFFSET );
-			assert( R->captures[ 0 ][1] != RX_NULL_OFFSET );
-			return 1;
+			if( out )
+			{
+				out->beg = pos;
+				out->end = end;
+			}
+			return id;
 		}
-		str++;
 	}
-	return 0;
+	return -1;
 }
 
-int srx_GetCaptureCount( srx_Context* R )
+
+srx_Stream* srx_CreateStream( srx_Context* R, srx_MatchFunc fn, void* userdata )
 {
-	return R->capture_count;
+	rxStream* S = (rxStream*) R->memfn( R->memctx, NULL, sizeof(rxStream) );
+	S->R = R;
+	S->fn = fn;
+	S->userdata = userdata;
+	S->buf = NULL;
+	S->buf_size = 0;
+	S->buf_mem = 0;
+	S->base = 0;
+	S->pos = 0;
+	S->stopped = 0;
+	S->retry = 0;
+	S->scanned = 0;
+	S->row = 0;
+	S->dfa = NULL;
+	S->dfa_built = 0;
+	return S;
 }
 
-int srx_GetCaptured( srx_Context* R, int which, size_t* pbeg, size_t* pend )
+void srx_DestroyStream( srx_Stream* S )
 {
-	if( which < 0 || which >= R->capture_count )
-		return 0;
-	if( R->captures[ which ][0] == RX_NULL_OFFSET ||
-		R->captures[ which ][1] == RX_NULL_OFFSET )
-		return 0;
-	if( pbeg ) *pbeg = R->captures[ which ][0];
-	if( pend ) *pend = R->captures[ which ][1];
-	return 1;
+	rxExecute* R = S->R;
+	if( S->buf )
+		R->memfn( R->memctx, S->buf, 0 );
+	if( S->dfa && S->dfa != R->ldfa )
+		rxFreeDFA( R, S->dfa );
+	R->memfn( R->memctx, S, 0 );
 }
 
-int srx_GetCapturedPtrs( srx_Context* R, int which, const rxChar** pbeg, const rxChar** pend )
+/* anchored DFA that follows the pending attempt (built on first use, the one of leftmost-longest contexts is borrowed) */
+static rxDFA* rxStreamDFA( rxStream* S )
 {
-	size_t a, b;
-	if( srx_GetCaptured( R, which, &a, &b ) )
+	rxExecute* R = S->R;
+	if( !S->dfa_built )
 	{
-		if( pbeg ) *pbeg = R->str + a;
-		if( pend ) *pend = R->str + b;
-		return 1;
+		rxNFA n;
+		S->dfa_built = 1;
+		if( R->ldfa )
+			S->dfa = R->ldfa;
+		else if( rxBuildNFA( R, &n, 0 ) )
+		{
+			S->dfa = rxBuildDFA( R, &n, RX_DFA_ANCHORED, RX_DFA_MAX_STATES );
+			rxFreeNFA( R, &n );
+		}
 	}
-	return 0;
+	return S->dfa;
 }
 
-
-rxChar* srx_ReplaceExt( srx_Context* R, const rxChar* str, size_t strsize, const rxChar* rep, size_t repsize, size_t* outsize )
+/* returns whether the pending attempt should wait for more data:
+   the DFA continues from where it stopped, once it dies no path of the attempt reaches the end and its result is final,
+   otherwise the attempt is only retried after the data since it started has doubled, so each byte is rescanned a bounded number of times */
+static int rxStreamWait( rxStream* S )
 {
-	rxChar* out = "";
-	const rxChar *from = str, *fromend = str + strsize, *repend = rep + repsize;
-	size_t size = 0, mem = 0;
-	
-#define SR_CHKSZ( szext ) \
-	if( (ptrdiff_t)( mem - size ) < (ptrdiff_t)(szext) ) \
-	{ \
-		size_t nsz = mem * 2 + (size_t)(szext); \
-		out = (rxChar*) R->memfn( R->memctx, mem ? out : NULL, sizeof(rxChar) * nsz ); \
-		mem = nsz; \
+	const rxDFA* d = S->dfa;
+	if( d )
+	{
+		uint32_t row = S->row;
+		size_t k;
+		for( k = S->scanned; k < S->buf_size && row; ++k )
+			row = d->trans[ row + d->classes[ (rxUChar) S->buf[ k ] ] ];
+		S->row = row;
+		S->scanned = k;
+		if( !row )
+			return 0;
 	}
-#define SR_ADDBUF( from, to ) \
-	SR_CHKSZ( to - from ) \
-	memcpy( out + size, from, (size_t)( to - from ) ); \
-	size += (size_t)( to - from );
-	
-	while( from < fromend )
+	return S->buf_size < S->retry;
+}
+
+static void rxStreamRun( rxStream* S, int at_end )
+{
+	rxExecute* R = S->R;
+	R->str = S->buf;
+	while( S->pos < S->buf_size && !S->stopped )
 	{
-		const rxChar* ofp = NULL, *ep = NULL, *rp;
-		if( !srx_MatchExt( R, from, (size_t)( fromend - from ), 0 ) )
-			break;
-		srx_GetCapturedPtrs( R, 0, &ofp, &ep );
-		SR_ADDBUF( from, ofp );
+		int match;
+		size_t end;
 		
-		rp = rep;
-		while( rp < repend )
+		if( S->retry && !at_end && rxStreamWait( S ) )
+			break;
+		rxResetCaptures( R );
+		R->hit_end = 0;
+		match = rxAttempt( R, S->buf, S->buf + S->pos, S->buf_size );
+		if( R->hit_end && !at_end )
 		{
-			rxChar rc = *rp;
-			if( ( rc == '\\' || rc == '$' ) && rp + 1 < repend )
+			/* more data could change the result, retry on a later feed */
+			rxResetCaptures( R );
+			if( !S->retry )
 			{
-				if( rxIsDigit( rp[1] ) )
-				{
-					int dig = rp[1] - '0';
-					const rxChar *brp, *erp;
-					if( srx_GetCapturedPtrs( R, dig, &brp, &erp ) )
-					{
-						SR_ADDBUF( brp, erp );
-					}
-					rp += 2;
-					continue;
-				}
-				else if( rp[1] == rc )
-				{
-					rp++;
-				}
+				const rxDFA* d = rxStreamDFA( S );
+				S->row = d ? ( S->base + S->pos ? d->mid_row : d->start_row ) : 0;
+				S->scanned = S->pos;
+			}
+			S->retry = S->buf_size + ( S->buf_size - S->pos );
+			break;
+		}
+		S->retry = 0;
+		if( !match )
+		{
+			/* sticky streams end at the first gap between matches */
+			if( R->flags & RCF_STICKY )
+			{
+				S->stopped = 1;
+				break;
 			}
-			SR_ADDBUF( rp, rp + 1 );
-			rp++;
+			S->pos++;
+			continue;
 		}
 		
-		if( from == ep )
-			from++;
-		else
-			from = ep;
+		end = R->captures[ 0 ][1];
+		R->stats.matches++;
+		if( rxReportMatch( R, S->base, S->fn, S->userdata ) )
+			S->stopped = 1;
+		S->pos = end == S->pos ? S->pos + 1 : end;
 	}
+}
+
+int srx_StreamFeed( srx_Stream* S, const rxChar* str, size_t size )
+{
+	rxExecute* R = S->R;
 	
-	SR_ADDBUF( from, fromend );
-	if( outsize )
-		*outsize = size;
+	if( S->stopped )
+		return 0;
+	
+	/* drop resolved data, keeping one character so that offset 0 is only ever the stream start */
+	if( S->pos > 1 )
 	{
-		char nul[1] = {0};
-		SR_ADDBUF( nul, &nul[1] );
+		size_t drop = S->pos - 1;
+		memmove( S->buf, S->buf + drop, S->buf_size - drop );
+		S->buf_size -= drop;
+		S->base += drop;
+		S->pos -= drop;
+		if( S->retry )
+		{
+			S->retry -= drop;
+			S->scanned -= drop;
+		}
 	}
-	return out;
+	
+	if( S->buf_size + size > RX_MAX_OFFSET )
+	{
+		S->stopped = 1;
+		return 0;
+	}
+	if( S->buf_size + size > S->buf_mem )
+	{
+		size_t ncnt = S->buf_mem * 2 + size;
+		S->buf = (rxChar*) R->memfn( R->memctx, S->buf, sizeof(rxChar) * ncnt );
+		S->buf_mem = ncnt;
+	}
+	memcpy( S->buf + S->buf_size, str, sizeof(rxChar) * size );
+	S->buf_size += size;
+	R->stats.calls++;
+	R->stats.bytes += size;
+	
+	rxStreamRun( S, 0 );
+	return !S->stopped;
 }
 
-void srx_FreeReplaced( srx_Context* R, rxChar* repstr )
+int srx_StreamFinish( srx_Stream* S )
 {
-	R->memfn( R->memctx, repstr, 0 );
+	if( S->stopped )
+		return 0;
+	S->R->stats.calls++;
+	rxStreamRun( S, 1 );
+	S->stopped = 1;
+	return 1;
 }
 
 
@@ -19,8 +19,38 @@ extern "C" {
 #define RXELIMIT  -5 /* too many digits */
 #define RXEEMPTY  -6 /* expression is effectively empty */
 #define RXENOREF  -7 /* the specified backreference cannot be used here */
+#define RXEPROG   -8 /* prebuilt program has out-of-range instruction arguments */
+#define RXEAUTO   -9 /* cannot be compiled to an automaton (backreferences, multiline anchors or size) */
 
-#define RX_ALLMODS "mis"
+#define RX_ALLMODS "misyl"
+
+#define RX_NOPOS ((size_t)-1) /* offset of a capture range that was not matched */
+
+#define RX_SPLIT_CAPTURES 0x1 /* srx_SplitExt: output capture ranges of delimiters */
+
+/* srx_Analysis flags */
+#define RX_AF_NESTED_REPEAT  0x01 /* a repeated part ends with a repeat that can also start it, like (a+)+ */
+#define RX_AF_EMPTY_REPEAT   0x02 /* an unbounded repeat of a part that can match an empty string, like (a?)* */
+#define RX_AF_AMBIGUOUS_ALT  0x04 /* a repeated alternation with branches that can start with the same character */
+#define RX_AF_BACKREF        0x08 /* uses backreferences */
+#define RX_AF_ANCHORED_START 0x10 /* matches can only start at the string start */
+#define RX_AF_ANCHORED_END   0x20 /* matches can only end at the string end */
+#define RX_AF_LITERAL        0x40 /* the pattern is a plain string */
+#define RX_AF_AUTOMATON      0x80 /* the pattern can be compiled to an automaton (no backreferences or multiline anchors) */
+#define RX_AF_ONE_PASS       0x100 /* at most one path can match from each position, captures are found without backtracking */
+
+/* srx_Analysis estimated worst-case matching time */
+#define RX_COST_LINEAR      0
+#define RX_COST_POLYNOMIAL  1
+#define RX_COST_EXPONENTIAL 2
+
+/* srx_Analysis engine */
+#define RX_ENGINE_BACKTRACK  0 /* backtracking matcher only */
+#define RX_ENGINE_DFA_FILTER 1 /* a DFA checks for a match before the backtracking matcher runs */
+#define RX_ENGINE_DFA_LONGEST 2 /* leftmost-longest matching ('l' modifier) with an anchored DFA, no backtracking */
+#define RX_ENGINE_REVERSE    3 /* end-anchored pattern: a reversed DFA scans back from the end to the first match start */
+#define RX_ENGINE_TWO_PHASE  4 /* DFAs find where the first match starts (on long inputs), the backtracking matcher runs from there */
+#define RX_ENGINE_BIT_PARALLEL 5 /* like RX_ENGINE_TWO_PHASE, with a bit-parallel NFA of up to 64 positions instead of DFAs too big to build */
 
 #ifndef RX_STRLENGTHFUNC
 #define RX_STRLENGTHFUNC( str ) strlen( str )
@@ -49,24 +79,195 @@ static void* srx_DefaultMemFunc( void* userdata, void* ptr, size_t size )
 typedef char rxChar;
 typedef unsigned char rxUChar;
 typedef struct _srx_Context srx_Context;
+typedef struct _srx_Stream srx_Stream;
+typedef struct _srx_Template srx_Template;
+typedef struct _srx_Lexer srx_Lexer;
+
+typedef struct srx_InstrProfile
+{
+	size_t exec;        /* times the instruction was executed */
+	size_t match;       /* times a matching instruction succeeded */
+	size_t fail;        /* times the instruction failed and started backtracking */
+	size_t backtrack;   /* times matching resumed at the instruction after backtracking */
+	size_t peak_states; /* largest backtracking stack size seen at the instruction */
+}
+srx_InstrProfile;
+
+typedef struct srx_Stats
+{
+	size_t calls;      /* matching calls (srx_MatchExt, find-all, split, replace, stream feeds, batch strings) */
+	size_t bytes;      /* input bytes covered by searches */
+	size_t starts;     /* match attempts by the backtracking matcher (start offsets tried) */
+	size_t matches;    /* matches found */
+	size_t steps;      /* instructions executed by the backtracking matcher */
+	size_t backtracks; /* times the backtracking matcher resumed at an earlier branch */
+	size_t max_depth;  /* largest backtracking stack size */
+	size_t reallocs;   /* reallocations of the backtracking and repeat counter stacks */
+	size_t prefilter_calls;   /* searches screened by automata first (DFA prefilter, first match location) */
+	size_t prefilter_rejects; /* screened searches that found no match without running the matcher */
+	size_t prefilter_skipped; /* start offsets skipped because no match could start there */
+}
+srx_Stats;
+
+typedef struct srx_Analysis
+{
+	int flags;             /* RX_AF_* */
+	int cost;              /* RX_COST_* */
+	int engine;            /* RX_ENGINE_* */
+	size_t min_length;     /* length of the shortest possible match */
+	size_t literal_length; /* characters of plain strings that every match contains */
+	size_t repeat_depth;   /* deepest nesting of unbounded repeats */
+}
+srx_Analysis;
+
+typedef struct srx_SlowInfo
+{
+	const rxChar* pattern; /* the pattern the context was created from */
+	size_t pattern_size;
+	const rxChar* str;     /* the input string */
+	size_t size;           /* length of the input string */
+	size_t offset;         /* starting offset of the search */
+	size_t steps;          /* instructions executed during the call */
+	size_t max_depth;      /* largest backtracking stack size during the call */
+	double seconds;        /* elapsed wall time of the call (0 if not measured) */
+}
+srx_SlowInfo;
+
+typedef struct srx_Instr
+{
+	unsigned op;    /* opcode (as printed by srx_DumpToFile) */
+	unsigned start; /* referenced instruction (repeats, jumps) */
+	unsigned from;  /* character data offset / minimum repeat count / capture slot */
+	unsigned len;   /* character data length / maximum repeat count */
+}
+srx_Instr;
+
+typedef struct srx_Program
+{
+	const srx_Instr* instrs; /* the compiled instructions, ending with MATCH_DONE */
+	size_t instrs_count;
+	const rxChar* chars;     /* character data of ranges and plain strings */
+	size_t chars_count;
+	int capture_count;       /* including the whole match */
+	const rxChar* pattern;   /* source pattern (optional, reported to the slow-call callback) */
+	size_t pattern_size;
+	const rxChar* mods;      /* modifiers the program was compiled with (optional) */
+}
+srx_Program;
+
+typedef struct srx_Span
+{
+	size_t beg; /* start offset of range */
+	size_t end; /* end offset of range */
+}
+srx_Span;
+
+typedef int (*srx_MatchFunc)
+(
+	void* /* userdata */,
+	srx_Context* /* R */,
+	const srx_Span* /* caps */,
+	int /* count */
+);
+
+typedef void (*srx_SlowFunc)
+(
+	void* /* userdata */,
+	srx_Context* /* R */,
+	const srx_SlowInfo* /* info */
+);
+
+typedef void (*srx_TaskFunc)
+(
+	void* /* taskdata */
+);
+
+typedef void (*srx_ParallelFunc)
+(
+	void* /* userdata */,
+	srx_TaskFunc /* fn */,
+	void** /* tasks */,
+	size_t /* count */
+);
+
+typedef int (*srx_WriteFunc)
+(
+	void* /* userdata */,
+	const rxChar* /* data */,
+	size_t /* size */
+);
+
+typedef int (*srx_ReplaceFunc)
+(
+	void* /* userdata */,
+	srx_Context* /* R */,
+	const srx_Span* /* caps */,
+	int /* count */,
+	srx_WriteFunc /* write */,
+	void* /* writedata */
+);
 
 
 srx_Context* srx_CreateExt( const rxChar* str, size_t strsize, const rxChar* mods, int* errnpos, srx_MemFunc memfn, void* memctx );
 #define srx_Create( str, mods ) srx_CreateExt( str, RX_STRLENGTHFUNC(str), mods, NULL, NULL, NULL )
+srx_Context* srx_CreateProgram( const srx_Program* P, int* errnpos, srx_MemFunc memfn, void* memctx );
 void srx_Destroy( srx_Context* R );
 void srx_DumpToFile( srx_Context* R, FILE* fp );
 #define srx_DumpToStdout( R ) srx_DumpToFile( R, stdout )
+int srx_GetProfile( srx_Context* R, int which, srx_InstrProfile* out );
+void srx_ResetProfile( srx_Context* R );
+void srx_GetStats( srx_Context* R, srx_Stats* out );
+void srx_ResetStats( srx_Context* R );
+void srx_Analyze( srx_Context* R, srx_Analysis* out );
+const char* srx_EngineName( int engine );
+void srx_SetSlowCallback( srx_Context* R, size_t max_steps, double max_seconds, srx_SlowFunc fn, void* userdata );
 
 int srx_MatchExt( srx_Context* R, const rxChar* str, size_t size, size_t offset );
 #define srx_Match( R, str, off ) srx_MatchExt( R, str, RX_STRLENGTHFUNC(str), off )
+int srx_MatchAt( srx_Context* R, const rxChar* str, size_t size, size_t offset );
+int srx_MatchLast( srx_Context* R, const rxChar* str, size_t size, size_t offset );
 int srx_GetCaptureCount( srx_Context* R );
 int srx_GetCaptured( srx_Context* R, int which, size_t* pbeg, size_t* pend );
 int srx_GetCapturedPtrs( srx_Context* R, int which, const rxChar** pbeg, const rxChar** pend );
 
+size_t srx_FindAllExt( srx_Context* R, const rxChar* str, size_t size, size_t offset, srx_Span* out, size_t maxmatches );
+#define srx_FindAll( R, str, out, maxmatches ) srx_FindAllExt( R, str, RX_STRLENGTHFUNC(str), 0, out, maxmatches )
+size_t srx_FindAllCb( srx_Context* R, const rxChar* str, size_t size, size_t offset, srx_MatchFunc fn, void* userdata );
+size_t srx_FindAllParallel( srx_Context* R, const rxChar* str, size_t size, size_t nchunks,
+	srx_ParallelFunc pfn, void* pdata, srx_MatchFunc fn, void* userdata );
+
+size_t srx_MatchBatch( srx_Context* R, const rxChar* const* strs, const size_t* sizes, size_t count,
+	unsigned char* bitmap, srx_Span* caps );
+size_t srx_MatchBatchParallel( srx_Context* R, const rxChar* const* strs, const size_t* sizes, size_t count,
+	unsigned char* bitmap, srx_Span* caps, size_t ntasks, srx_ParallelFunc pfn, void* pdata );
+
+size_t srx_SplitExt( srx_Context* R, const rxChar* str, size_t size, srx_Span* out, size_t maxspans, size_t maxsplits, int flags );
+#define srx_Split( R, str, out, maxspans ) srx_SplitExt( R, str, RX_STRLENGTHFUNC(str), out, maxspans, 0, 0 )
+
 rxChar* srx_ReplaceExt( srx_Context* R, const rxChar* str, size_t strsize, const rxChar* rep, size_t repsize, size_t* outsize );
 #define srx_Replace( R, str, rep ) srx_ReplaceExt( R, str, RX_STRLENGTHFUNC(str), rep, RX_STRLENGTHFUNC(rep), NULL )
 void srx_FreeReplaced( srx_Context* R, rxChar* repstr );
 
+srx_Template* srx_CreateTemplateExt( srx_Context* R, const rxChar* rep, size_t repsize );
+#define srx_CreateTemplate( R, rep ) srx_CreateTemplateExt( R, rep, RX_STRLENGTHFUNC(rep) )
+void srx_DestroyTemplate( srx_Template* T );
+size_t srx_ReplaceSink( srx_Context* R, const rxChar* str, size_t strsize, const srx_Template* T, srx_WriteFunc fn, void* userdata );
+size_t srx_ReplaceBuf( srx_Context* R, const rxChar* str, size_t strsize, const srx_Template* T, rxChar* buf, size_t bufsize );
+rxChar* srx_ReplaceCbExt( srx_Context* R, const rxChar* str, size_t strsize, srx_ReplaceFunc fn, void* userdata, size_t* outsize );
+#define srx_ReplaceCb( R, str, fn, userdata ) srx_ReplaceCbExt( R, str, RX_STRLENGTHFUNC(str), fn, userdata, NULL )
+size_t srx_ReplaceCbSink( srx_Context* R, const rxChar* str, size_t strsize, srx_ReplaceFunc fn, void* userdata, srx_WriteFunc wfn, void* wdata );
+
+srx_Lexer* srx_CreateLexer( const rxChar* const* patterns, const size_t* sizes, size_t count, const rxChar* mods,
+	int* errnpos, srx_MemFunc memfn, void* memctx );
+void srx_DestroyLexer( srx_Lexer* L );
+int srx_LexerMatch( const srx_Lexer* L, const rxChar* str, size_t size, size_t offset, size_t* pend );
+int srx_LexerFind( const srx_Lexer* L, const rxChar* str, size_t size, size_t offset, srx_Span* out );
+
+srx_Stream* srx_CreateStream( srx_Context* R, srx_MatchFunc fn, void* userdata );
+void srx_DestroyStream( srx_Stream* S );
+int srx_StreamFeed( srx_Stream* S, const rxChar* str, size_t size );
+int srx_StreamFinish( srx_Stream* S );
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,858 @@
+#ifndef SG_REGEX_HPP_
+#define SG_REGEX_HPP_
+
+/* C++17 interface: move-only regex, string_view results, lazy match ranges, std::pmr allocation */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "sgregex.h"
+
+
+namespace srx {
+
+/* highest number of capture ranges (including the whole match) */
+constexpr int max_groups = 10;
+
+/* pattern compilation failure, `code` is one of RXE* */
+class error : public std::runtime_error
+{
+public:
+	error( int code, int position ) :
+		std::runtime_error( "sgregex: invalid pattern" ), m_code( code ), m_position( position ) {}
+	int code() const noexcept { return m_code; }
+	int position() const noexcept { return m_position; }
+
+private:
+	int m_code;
+	int m_position;
+};
+
+namespace detail {
+
+/* srx_MemFunc over a std::pmr::memory_resource, blocks are prefixed with their size for reallocation */
+constexpr std::size_t pmr_header = alignof(std::max_align_t) > sizeof(std::size_t) ? alignof(std::max_align_t) : sizeof(std::size_t);
+
+inline void* pmr_memfunc( void* userdata, void* ptr, std::size_t size )
+{
+	std::pmr::memory_resource* mr = static_cast<std::pmr::memory_resource*>( userdata );
+	char* out = nullptr;
+	if( size )
+	{
+		out = static_cast<char*>( mr->allocate( size + pmr_header, alignof(std::max_align_t) ) );
+		std::memcpy( out, &size, sizeof(size) );
+		out += pmr_header;
+	}
+	if( ptr )
+	{
+		char* block = static_cast<char*>( ptr ) - pmr_header;
+		std::size_t oldsize;
+		std::memcpy( &oldsize, block, sizeof(oldsize) );
+		if( out )
+			std::memcpy( out, ptr, oldsize < size ? oldsize : size );
+		mr->deallocate( block, oldsize + pmr_header, alignof(std::max_align_t) );
+	}
+	return out;
+}
+
+inline int append_string( void* userdata, const rxChar* data, std::size_t size )
+{
+	static_cast<std::string*>( userdata )->append( data, size );
+	return 0;
+}
+
+} // namespace detail
+
+
+/* capture ranges of one match, viewing the searched string (no copies) */
+class match
+{
+public:
+	match() : m_count( 0 ) {}
+	
+	/* number of capture ranges, 0 if there is no match */
+	int size() const noexcept { return m_count; }
+	bool empty() const noexcept { return m_count == 0; }
+	explicit operator bool() const noexcept { return m_count != 0; }
+	
+	bool matched( int i = 0 ) const noexcept { return i >= 0 && i < m_count && m_spans[ i ].beg != RX_NOPOS; }
+	std::size_t position( int i = 0 ) const noexcept { return matched( i ) ? m_spans[ i ].beg : RX_NOPOS; }
+	std::size_t length( int i = 0 ) const noexcept { return matched( i ) ? m_spans[ i ].end - m_spans[ i ].beg : 0; }
+	
+	/* the captured text, empty if the range was not matched */
+	std::string_view str( int i = 0 ) const noexcept
+	{
+		return matched( i ) ? m_subject.substr( m_spans[ i ].beg, m_spans[ i ].end - m_spans[ i ].beg ) : std::string_view();
+	}
+	std::string_view operator[]( int i ) const noexcept { return str( i ); }
+
+private:
+	friend class regex;
+	friend class match_iterator;
+	
+	void assign( std::string_view subject, const srx_Span* spans, int count ) noexcept
+	{
+		m_subject = subject;
+		m_count = count;
+		for( int i = 0; i < count; ++i )
+			m_spans[ i ] = spans[ i ];
+	}
+	
+	std::string_view m_subject;
+	srx_Span m_spans[ max_groups ];
+	int m_count;
+};
+
+
+class regex;
+
+/* input iterator over consecutive non-overlapping matches (same order and ranges as srx_FindAllCb),
+   advancing runs the next search, so only one iterator per regex should be in use at a time */
+class match_iterator
+{
+public:
+	using iterator_category = std::input_iterator_tag;
+	using value_type = match;
+	using difference_type = std::ptrdiff_t;
+	using pointer = const match*;
+	using reference = const match&;
+	
+	match_iterator() noexcept : m_re( nullptr ), m_next( 0 ) {}
+	inline match_iterator( regex& re, std::string_view subject, std::size_t offset );
+	
+	reference operator*() const noexcept { return m_match; }
+	pointer operator->() const noexcept { return &m_match; }
+	inline match_iterator& operator++();
+	match_iterator operator++( int ) { match_iterator it( *this ); ++*this; return it; }
+	
+	friend bool operator==( const match_iterator& a, const match_iterator& b ) noexcept { return a.m_re == b.m_re; }
+	friend bool operator!=( const match_iterator& a, const match_iterator& b ) noexcept { return a.m_re != b.m_re; }
+
+private:
+	inline void find();
+	
+	regex* m_re; /* NULL at the end */
+	std::string_view m_subject;
+	std::size_t m_next;
+	match m_match;
+};
+
+class match_range
+{
+public:
+	match_range( regex& re, std::string_view subject, std::size_t offset ) noexcept :
+		m_re( &re ), m_subject( subject ), m_offset( offset ) {}
+	match_iterator begin() const { return match_iterator( *m_re, m_subject, m_offset ); }
+	match_iterator end() const noexcept { return match_iterator(); }
+
+private:
+	regex* m_re;
+	std::string_view m_subject;
+	std::size_t m_offset;
+};
+
+
+/* parsed replacement string (see srx_CreateTemplate), independent of the regex after creation */
+class replacement
+{
+public:
+	inline replacement( regex& re, std::string_view rep );
+	replacement( replacement&& o ) noexcept : m_tpl( std::exchange( o.m_tpl, nullptr ) ) {}
+	replacement& operator=( replacement&& o ) noexcept { std::swap( m_tpl, o.m_tpl ); return *this; }
+	replacement( const replacement& ) = delete;
+	replacement& operator=( const replacement& ) = delete;
+	~replacement() { if( m_tpl ) srx_DestroyTemplate( m_tpl ); }
+	
+	const srx_Template* native_handle() const noexcept { return m_tpl; }
+
+private:
+	srx_Template* m_tpl;
+};
+
+
+/* compiled pattern and matcher state, not thread-safe (each thread needs its own regex) */
+class regex
+{
+public:
+	/* throws srx::error on invalid patterns, `mr` (optional) must outlive the regex and should not throw */
+	explicit regex( std::string_view pattern, const char* mods = "", std::pmr::memory_resource* mr = nullptr )
+	{
+		int err[ 2 ] = { 0, 0 };
+		m_ctx = srx_CreateExt( pattern.data(), pattern.size(), mods, err,
+			mr ? detail::pmr_memfunc : nullptr, mr );
+		if( !m_ctx )
+			throw error( err[0], err[1] );
+	}
+	/* prebuilt program (see srx_CreateProgram and srx::ct::program), throws srx::error if it is invalid */
+	explicit regex( const srx_Program& program, std::pmr::memory_resource* mr = nullptr )
+	{
+		int err[ 2 ] = { 0, 0 };
+		m_ctx = srx_CreateProgram( &program, err, mr ? detail::pmr_memfunc : nullptr, mr );
+		if( !m_ctx )
+			throw error( err[0], err[1] );
+	}
+	regex( regex&& o ) noexcept : m_ctx( std::exchange( o.m_ctx, nullptr ) ) {}
+	regex& operator=( regex&& o ) noexcept { std::swap( m_ctx, o.m_ctx ); return *this; }
+	regex( const regex& ) = delete;
+	regex& operator=( const regex& ) = delete;
+	~regex() { if( m_ctx ) srx_Destroy( m_ctx ); }
+	
+	srx_Context* native_handle() const noexcept { return m_ctx; }
+	int group_count() const { return srx_GetCaptureCount( m_ctx ); }
+	
+	/* whether there is a match at or after `offset` */
+	bool test( std::string_view s, std::size_t offset = 0 )
+	{
+		return srx_MatchExt( m_ctx, s.data(), s.size(), offset ) != 0;
+	}
+	
+	/* finds the first match at or after `offset`, `m` views `s` */
+	bool search( std::string_view s, match& m, std::size_t offset = 0 )
+	{
+		return get_match( s, m, srx_MatchExt( m_ctx, s.data(), s.size(), offset ) );
+	}
+	match search( std::string_view s, std::size_t offset = 0 )
+	{
+		match m;
+		search( s, m, offset );
+		return m;
+	}
+	
+	/* finds the match that starts last at or after `offset` (it can overlap an earlier match of find_all) */
+	bool search_last( std::string_view s, match& m, std::size_t offset = 0 )
+	{
+		return get_match( s, m, srx_MatchLast( m_ctx, s.data(), s.size(), offset ) );
+	}
+	match search_last( std::string_view s, std::size_t offset = 0 )
+	{
+		match m;
+		search_last( s, m, offset );
+		return m;
+	}
+	
+	/* matches only at `offset` (which may be the end of `s`), the text before it is still seen by `^` */
+	bool match_at( std::string_view s, match& m, std::size_t offset )
+	{
+		return get_match( s, m, srx_MatchAt( m_ctx, s.data(), s.size(), offset ) );
+	}
+	match match_at( std::string_view s, std::size_t offset )
+	{
+		match m;
+		match_at( s, m, offset );
+		return m;
+	}
+	
+	/* lazy range of all non-overlapping matches */
+	match_range find_all( std::string_view s, std::size_t offset = 0 ) noexcept
+	{
+		return match_range( *this, s, offset );
+	}
+	
+	/* replaces all matches, appending the result to `out`, returns the number of replaced matches */
+	std::size_t replace( std::string_view s, const replacement& rep, std::string& out )
+	{
+		return srx_ReplaceSink( m_ctx, s.data(), s.size(), rep.native_handle(), detail::append_string, &out );
+	}
+	std::size_t replace( std::string_view s, std::string_view rep, std::string& out )
+	{
+		replacement tpl( *this, rep );
+		return replace( s, tpl, out );
+	}
+	
+	/* replaces all matches with what `fn( const srx::match&, std::string& out )` appends to `out`,
+	   `fn` may return bool (false stops replacing) or void, it must not throw */
+	template< class F > std::size_t replace_with( std::string_view s, std::string& out, F&& fn )
+	{
+		struct Call
+		{
+			F* fn;
+			std::string* out;
+			std::string_view subject;
+			
+			static int run( void* userdata, srx_Context* R, const srx_Span* caps, int count, srx_WriteFunc, void* )
+			{
+				Call* c = static_cast<Call*>( userdata );
+				match m;
+				(void) R;
+				m.assign( c->subject, caps, count );
+				if constexpr( std::is_same_v< decltype( (*c->fn)( m, *c->out ) ), void > )
+				{
+					(*c->fn)( m, *c->out );
+					return 0;
+				}
+				else
+					return (*c->fn)( m, *c->out ) ? 0 : 1;
+			}
+		};
+		Call call = { &fn, &out, s };
+		return srx_ReplaceCbSink( m_ctx, s.data(), s.size(), Call::run, &call, detail::append_string, &out );
+	}
+
+private:
+	bool get_match( std::string_view s, match& m, int found )
+	{
+		srx_Span spans[ max_groups ];
+		int count;
+		if( !found )
+		{
+			m = match();
+			return false;
+		}
+		count = srx_GetCaptureCount( m_ctx );
+		for( int i = 0; i < count; ++i )
+		{
+			if( !srx_GetCaptured( m_ctx, i, &spans[ i ].beg, &spans[ i ].end ) )
+				spans[ i ].beg = spans[ i ].end = RX_NOPOS;
+		}
+		m.assign( s, spans, count );
+		return true;
+	}
+	
+	srx_Context* m_ctx;
+};
+
+
+inline replacement::replacement( regex& re, std::string_view rep ) :
+	m_tpl( srx_CreateTemplateExt( re.native_handle(), rep.data(), rep.size() ) )
+{
+}
+
+inline match_iterator::match_iterator( regex& re, std::string_view subject, std::size_t offset ) :
+	m_re( &re ), m_subject( subject ), m_next( offset )
+{
+	find();
+}
+
+inline match_iterator& match_iterator::operator++()
+{
+	find();
+	return *this;
+}
+
+inline void match_iterator::find()
+{
+	if( m_next > m_subject.size() || !m_re->search( m_subject, m_match, m_next ) )
+	{
+		m_re = nullptr;
+		return;
+	}
+	/* empty matches advance by one character to avoid finding them again */
+	m_next = m_match.length() ? m_match.position() + m_match.length() : m_match.position() + 1;
+}
+
+
+#if __cplusplus >= 202002L
+/* C++20 compile-time compilation: pattern literals are compiled by the C++ compiler into constant
+   instruction and character tables (the same program srx_CreateExt would build), which the regular
+   matcher runs without parsing anything at runtime, invalid patterns and modifiers fail to compile */
+namespace ct {
+
+/* pattern or modifier literal usable as a template argument */
+template< std::size_t N > struct fixed_string
+{
+	char data[ N ] = {};
+	
+	constexpr fixed_string( const char (&s)[ N ] )
+	{
+		for( std::size_t i = 0; i < N; ++i )
+			data[ i ] = s[ i ];
+	}
+	constexpr std::size_t size() const noexcept { return N - 1; }
+};
+
+/* compiler output, sized for the longest program a pattern of N - 1 characters can produce
+   (up to two instructions and four characters of data per pattern character) */
+template< std::size_t N > struct compiled
+{
+	srx_Instr instrs[ N * 2 + 1 ] = {};
+	char chars[ N * 4 ] = {};
+	std::size_t instrs_count = 0;
+	std::size_t chars_count = 0;
+	int capture_count = 0;
+	int errcode = RXSUCCESS; /* RXE* */
+	int errpos = 0;
+};
+
+namespace detail {
+
+/* values of the RX_OP_* opcodes in sgregex.c */
+enum : unsigned
+{
+	op_match_done,
+	op_match_charset,
+	op_match_charset_inv,
+	op_match_string,
+	op_match_backref,
+	op_match_slstart,
+	op_match_slend,
+	op_repeat_greedy,
+	op_repeat_lazy,
+	op_jump,
+	op_backtrk_jump,
+	op_capture_start,
+	op_capture_end,
+};
+
+constexpr int max_captures = max_groups;
+constexpr int max_subexprs = 255;
+constexpr std::uint32_t max_repeats = 0xffffffff;
+constexpr unsigned null_instroff = 0x0fffffff;
+
+constexpr bool is_digit( char c ) noexcept { return c >= '0' && c <= '9'; }
+constexpr char to_lower( char c ) noexcept { return c >= 'A' && c <= 'Z' ? char( c - 'A' + 'a' ) : c; }
+
+/* constexpr port of rxCompile, must stay in sync with it (sgregex_test_ct.cpp compares the output) */
+template< std::size_t N > class compiler
+{
+public:
+	compiled< N > c;
+	
+	constexpr compiler( const char* mods )
+	{
+		for( const char* m = mods; *m; ++m )
+		{
+			if( *m == 's' )
+				m_dotall = true;
+			else if( *m != 'm' && *m != 'i' && *m != 'y' && *m != 'l' )
+			{
+				fail( RXEINMOD, int( m - mods ) );
+				return;
+			}
+		}
+		m_subexprs[ 0 ] = { 1, 1, 1, 0 };
+	}
+	
+	constexpr void compile( const char* str, std::size_t strsize )
+	{
+		bool empty = true;
+		const char* s = str;
+		const char* strend = str + strsize;
+		
+		if( c.errcode != RXSUCCESS )
+			return;
+		
+		push_instr( op_capture_start, 0, 0, 0 );
+		c.capture_count++;
+		
+		while( s != strend )
+		{
+			switch( *s )
+			{
+			case '[':
+				{
+					const char* sc;
+					unsigned op = op_match_charset;
+					unsigned start = unsigned( c.chars_count );
+					
+					if( ++s == strend )
+						return fail( RXEPART, int( s - str ) );
+					if( *s == '^' )
+					{
+						op = op_match_charset_inv;
+						if( ++s == strend )
+							return fail( RXEPART, int( s - str ) );
+					}
+					sc = s;
+					
+					if( *s == ']' )
+					{
+						if( ++s == strend )
+							return fail( RXEPART, int( s - str ) );
+						push_char( *s );
+						push_char( *s );
+					}
+					while( s != strend && *s != ']' )
+					{
+						if( *s == '-' && s > sc && s + 1 != strend && s[1] != ']' )
+						{
+							if( c.chars_count - start )
+							{
+								if( unsigned( s[1] ) < unsigned( c.chars[ c.chars_count - 1 ] ) )
+									return fail( RXERANGE, int( s - str ) );
+								c.chars[ c.chars_count - 1 ] = s[1];
+							}
+							if( ++s == strend )
+								return fail( RXEPART, int( s - str ) );
+						}
+						else if( *s == '\\' )
+						{
+							if( ++s == strend )
+								return fail( RXEPART, int( s - str ) );
+							if( push_char_class_data( *s ) == 0 )
+							{
+								push_char( *s );
+								push_char( *s );
+							}
+						}
+						else
+						{
+							push_char( *s );
+							push_char( *s );
+						}
+						if( ++s == strend )
+							return fail( RXEPART, int( s - str ) );
+					}
+					if( *s == ']' )
+						s++;
+					
+					push_instr( op, 0, start, unsigned( c.chars_count ) - start );
+					last_subexpr().repeat_start = unsigned( c.instrs_count - 1 );
+				}
+				break;
+			
+			case ']':
+			case '}':
+				return fail( RXEUNEXP, int( s - str ) );
+			
+			case '^':
+			case '$':
+				push_instr( *s == '^' ? op_match_slstart : op_match_slend, 0, 0, 0 );
+				last_subexpr().repeat_start = unsigned( c.instrs_count );
+				empty = false;
+				s++;
+				break;
+			
+			case '(':
+				if( m_subexprs_count >= max_subexprs )
+					return fail( RXELIMIT, int( s - str ) );
+				
+				fix_last_instr();
+				last_subexpr().repeat_start = unsigned( c.instrs_count );
+				m_subexprs[ m_subexprs_count ].capture_slot = 0;
+				if( c.capture_count < max_captures )
+				{
+					push_instr( op_capture_start, 0, unsigned( c.capture_count ), 0 );
+					m_subexprs[ m_subexprs_count ].capture_slot = c.capture_count;
+					c.capture_count++;
+				}
+				m_subexprs[ m_subexprs_count ].start = unsigned( c.instrs_count );
+				m_subexprs[ m_subexprs_count ].section_start = unsigned( c.instrs_count );
+				m_subexprs[ m_subexprs_count ].repeat_start = unsigned( c.instrs_count );
+				m_subexprs_count++;
+				s++;
+				break;
+			
+			case ')':
+				if( m_subexprs_count < 2 || last_subexpr().section_start == c.instrs_count )
+					return fail( RXEUNEXP, int( s - str ) );
+				
+				fix_last_instr();
+				fix_or_jumps();
+				m_subexprs_count--;
+				if( m_subexprs[ m_subexprs_count ].capture_slot )
+					push_instr( op_capture_end, 0, unsigned( m_subexprs[ m_subexprs_count ].capture_slot ), 0 );
+				s++;
+				break;
+			
+			case '|':
+				if( last_subexpr().section_start == c.instrs_count )
+					return fail( RXEUNEXP, int( s - str ) );
+				
+				push_instr( op_jump, null_instroff, 0, 0 );
+				insert_instr( last_subexpr().section_start, op_backtrk_jump, unsigned( c.instrs_count + 1 ), 0, 0 );
+				last_subexpr().section_start = unsigned( c.instrs_count );
+				last_subexpr().repeat_start = unsigned( c.instrs_count );
+				s++;
+				break;
+			
+			case '?':
+				if( c.instrs_count && c.instrs[ c.instrs_count - 1 ].op == op_repeat_greedy )
+				{
+					c.instrs[ c.instrs_count - 1 ].op = op_repeat_lazy;
+					s++;
+					break;
+				}
+				[[fallthrough]];
+			
+			case '+':
+			case '*':
+			case '{':
+				{
+					std::uint32_t min = 0, max = max_repeats;
+					
+					if( c.instrs_count &&
+						( c.instrs[ c.instrs_count - 1 ].op == op_repeat_lazy || c.instrs[ c.instrs_count - 1 ].op == op_repeat_greedy ) )
+						return fail( RXEUNEXP, int( s - str ) );
+					if( c.instrs_count == last_subexpr().repeat_start )
+						return fail( RXEUNEXP, int( s - str ) );
+					
+					if( *s == '+' )
+						min = 1;
+					else if( *s == '?' )
+						max = 1;
+					else if( *s == '{' )
+					{
+						if( ++s == strend )
+							return fail( RXEPART, int( s - str ) );
+						if( !is_digit( *s ) )
+							return fail( RXEUNEXP, int( s - str ) );
+						while( is_digit( *s ) )
+						{
+							std::uint32_t nmin = min * 10 + std::uint32_t( *s - '0' );
+							if( nmin < min )
+								return fail( RXELIMIT, int( s - str ) );
+							min = nmin;
+							if( ++s == strend )
+								return fail( RXEPART, int( s - str ) );
+						}
+						if( *s == ',' )
+						{
+							if( ++s == strend )
+								return fail( RXEPART, int( s - str ) );
+							if( *s != '}' )
+							{
+								if( !is_digit( *s ) )
+									return fail( RXEUNEXP, int( s - str ) );
+								max = 0;
+								while( is_digit( *s ) )
+								{
+									std::uint32_t nmax = max * 10 + std::uint32_t( *s - '0' );
+									if( nmax < max )
+										return fail( RXELIMIT, int( s - str ) );
+									max = nmax;
+									if( ++s == strend )
+										return fail( RXEPART, int( s - str ) );
+								}
+								if( min > max )
+									return fail( RXERANGE, int( s - str ) );
+							}
+						}
+						else
+							max = min;
+						if( *s != '}' )
+							return fail( RXEUNEXP, int( s - str ) );
+					}
+					
+					insert_instr( last_subexpr().repeat_start, op_jump, unsigned( c.instrs_count + 1 ), 0, 0 );
+					push_instr( op_repeat_greedy, last_subexpr().repeat_start + 1, min, max );
+				}
+				last_subexpr().repeat_start = unsigned( c.instrs_count );
+				s++;
+				break;
+			
+			case '.':
+				if( m_dotall )
+					push_instr( op_match_charset_inv, 0, unsigned( c.chars_count ), 0 );
+				else
+				{
+					push_instr( op_match_charset_inv, 0, unsigned( c.chars_count ), 4 );
+					push_chars( "\n\n\r\r" );
+				}
+				last_subexpr().repeat_start = unsigned( c.instrs_count - 1 );
+				s++;
+				break;
+			
+			case '\\':
+				if( ++s == strend )
+					return fail( RXEPART, int( s - str ) );
+				if( is_digit( *s ) )
+				{
+					int dig = *s++ - '0';
+					if( dig == 0 || dig >= c.capture_count )
+						return fail( RXENOREF, int( s - str ) );
+					push_instr( op_match_backref, 0, unsigned( dig ), 0 );
+					last_subexpr().repeat_start = unsigned( c.instrs_count - 1 );
+					break;
+				}
+				else
+				{
+					unsigned count = push_char_class_data( to_lower( *s ) );
+					if( count )
+					{
+						push_instr( *s >= 'a' && *s <= 'z' ? op_match_charset : op_match_charset_inv, 0, unsigned( c.chars_count ) - count, count );
+						last_subexpr().repeat_start = unsigned( c.instrs_count - 1 );
+						s++;
+						break;
+					}
+				}
+				[[fallthrough]];
+			
+			default:
+				push_instr( op_match_string, 0, unsigned( c.chars_count ), 1 );
+				push_char( *s++ );
+				last_subexpr().repeat_start = unsigned( c.instrs_count - 1 );
+				break;
+			}
+			
+			if( empty &&
+				c.instrs_count &&
+				c.instrs[ c.instrs_count - 1 ].op != op_capture_end &&
+				last_subexpr().repeat_start < c.instrs_count )
+				empty = false;
+		}
+		
+		if( empty )
+			return fail( RXEEMPTY, 0 );
+		if( last_subexpr().section_start == c.instrs_count )
+			return fail( RXEPART, int( s - str ) );
+		
+		fix_last_instr();
+		fix_or_jumps();
+		push_instr( op_capture_end, 0, 0, 0 );
+		push_instr( op_match_done, 0, 0, 0 );
+	}
+
+private:
+	struct subexpr
+	{
+		unsigned start;
+		unsigned section_start;
+		unsigned repeat_start;
+		int capture_slot;
+	};
+	
+	subexpr m_subexprs[ max_subexprs ] = {};
+	int m_subexprs_count = 1;
+	bool m_dotall = false;
+	
+	constexpr void fail( int code, int pos )
+	{
+		c.errcode = code;
+		c.errpos = pos;
+	}
+	constexpr subexpr& last_subexpr() { return m_subexprs[ m_subexprs_count - 1 ]; }
+	
+	constexpr void fix_last_instr()
+	{
+		if( c.instrs_count >= 2 &&
+			c.instrs[ c.instrs_count - 1 ].op == op_match_string &&
+			c.instrs[ c.instrs_count - 2 ].op == op_match_string )
+		{
+			c.instrs[ c.instrs_count - 2 ].len++;
+			c.instrs_count--;
+		}
+	}
+	
+	constexpr void fix_or_jumps()
+	{
+		for( std::size_t i = last_subexpr().start; i < c.instrs_count; ++i )
+		{
+			if( c.instrs[ i ].op == op_jump && c.instrs[ i ].start == null_instroff )
+				c.instrs[ i ].start = unsigned( c.instrs_count ) & 0x0fffffff;
+		}
+	}
+	
+	constexpr void insert_instr( unsigned pos, unsigned op, unsigned start, unsigned from, unsigned len )
+	{
+		for( std::size_t i = c.instrs_count; i > pos; --i )
+			c.instrs[ i ] = c.instrs[ i - 1 ];
+		c.instrs_count++;
+		for( std::size_t i = 0; i < c.instrs_count; ++i )
+		{
+			unsigned iop = c.instrs[ i ].op;
+			if( c.instrs[ i ].start > pos && c.instrs[ i ].start != null_instroff &&
+				( iop == op_repeat_greedy || iop == op_repeat_lazy || iop == op_jump || iop == op_backtrk_jump ) )
+				c.instrs[ i ].start++;
+		}
+		c.instrs[ pos ] = { op & 0xf, start & 0x0fffffff, from, len };
+	}
+	
+	constexpr void push_instr( unsigned op, unsigned start, unsigned from, unsigned len )
+	{
+		fix_last_instr();
+		c.instrs[ c.instrs_count++ ] = { op & 0xf, start & 0x0fffffff, from, len };
+	}
+	
+	constexpr void push_char( char ch ) { c.chars[ c.chars_count++ ] = ch; }
+	template< std::size_t M > constexpr void push_chars( const char (&str)[ M ] )
+	{
+		for( std::size_t i = 0; i + 1 < M; ++i )
+			push_char( str[ i ] );
+	}
+	
+	constexpr unsigned push_char_class_data( char cch )
+	{
+		std::size_t cc = c.chars_count;
+		switch( cch )
+		{
+		case 'd': push_chars( "09" ); break;
+		case 'h': push_chars( "\t\t  " ); break;
+		case 'v': push_chars( "\x0A\x0D" ); break;
+		case 's': push_chars( "\x09\x0D  " ); break;
+		case 'w': push_chars( "azAZ09__" ); break;
+		}
+		return unsigned( c.chars_count - cc );
+	}
+};
+
+template< std::size_t N > constexpr compiled< N > compile( const char* str, const char* mods )
+{
+	compiler< N > cc( mods );
+	cc.compile( str, N - 1 );
+	return cc.c;
+}
+
+/* not constexpr, so reaching it while compiling a pattern at compile time is a compile error,
+   the diagnostic shows the RXE* error code and position (see compile_result) */
+inline void invalid_pattern( int /* code */, int /* position */ ) {}
+
+constexpr bool check_pattern( int code, int position )
+{
+	if( code != RXSUCCESS )
+		invalid_pattern( code, position );
+	return true;
+}
+
+template< class T, std::size_t N > constexpr std::array< T, N > to_array( const T* data )
+{
+	std::array< T, N > out = {};
+	for( std::size_t i = 0; i < N; ++i )
+		out[ i ] = data[ i ];
+	return out;
+}
+
+} // namespace detail
+
+/* the compiler output for a pattern, errors are reported in `errcode` and `errpos` instead of failing to compile */
+template< fixed_string Pattern, fixed_string Mods = "" >
+inline constexpr compiled< sizeof(Pattern.data) > compile_result = detail::compile< sizeof(Pattern.data) >( Pattern.data, Mods.data );
+
+namespace detail {
+
+/* the program trimmed to its actual size */
+template< fixed_string Pattern, fixed_string Mods > struct tables
+{
+	static constexpr const auto& c = compile_result< Pattern, Mods >;
+	static_assert( check_pattern( c.errcode, c.errpos ), "sgregex: invalid pattern" );
+	
+	static constexpr std::array< srx_Instr, c.instrs_count > instrs = to_array< srx_Instr, c.instrs_count >( c.instrs );
+	static constexpr std::array< char, c.chars_count > chars = to_array< char, c.chars_count >( c.chars );
+};
+
+} // namespace detail
+
+/* the program for srx_CreateProgram / srx::regex, an invalid pattern or modifier fails to compile */
+template< fixed_string Pattern, fixed_string Mods = "" >
+inline constexpr srx_Program program =
+{
+	detail::tables< Pattern, Mods >::instrs.data(), detail::tables< Pattern, Mods >::instrs.size(),
+	detail::tables< Pattern, Mods >::chars.data(), detail::tables< Pattern, Mods >::chars.size(),
+	compile_result< Pattern, Mods >.capture_count,
+	Pattern.data, Pattern.size(),
+	Mods.data,
+};
+
+/* srx::regex created from a compile-time program, e.g. `srx::ct::regex< "(\\d+)-(\\d+)" > re;` */
+template< fixed_string Pattern, fixed_string Mods = "" > class regex : public srx::regex
+{
+public:
+	explicit regex( std::pmr::memory_resource* mr = nullptr ) : srx::regex( program< Pattern, Mods >, mr ) {}
+};
+
+} // namespace ct
+#endif
+
+} // namespace srx
+
+
+#endif /* SG_REGEX_HPP_ */
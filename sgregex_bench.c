@@ -0,0 +1,354 @@
+
+#include "sgregex.c"
+
+
+/* allocation counting */
+static size_t bench_allocs;
+static void* bench_memfn( void* userdata, void* ptr, size_t size )
+{
+	(void) userdata;
+	if( size )
+	{
+		bench_allocs++;
+		return realloc( ptr, size );
+	}
+	free( ptr );
+	return NULL;
+}
+
+
+/* deterministic corpora (xorshift32, fixed seed per corpus) */
+static uint32_t bench_seed;
+static uint32_t brand( uint32_t n )
+{
+	bench_seed ^= bench_seed << 13;
+	bench_seed ^= bench_seed >> 17;
+	bench_seed ^= bench_seed << 5;
+	return bench_seed % n;
+}
+
+typedef struct Corpus
+{
+	const char*  name;
+	char*        data;
+	size_t       size;
+	size_t       mem;
+	const char** lines;
+	size_t*      line_sizes;
+	size_t       line_count;
+}
+Corpus;
+
+static void corpus_append( Corpus* C, const char* str, size_t size )
+{
+	if( C->size + size > C->mem )
+	{
+		C->mem = C->mem * 2 + size;
+		C->data = (char*) realloc( C->data, C->mem );
+	}
+	memcpy( C->data + C->size, str, size );
+	C->size += size;
+}
+
+static const char* words[] =
+{
+	"the", "of", "and", "a", "to", "in", "is", "you", "that", "it", "he", "was", "for", "on", "are", "as",
+	"with", "his", "they", "at", "be", "this", "have", "from", "or", "one", "had", "by", "word", "but",
+	"not", "what", "all", "were", "we", "when", "your", "can", "said", "there", "use", "an", "each",
+	"which", "she", "do", "how", "their", "if", "will", "up", "other", "about", "out", "many", "then",
+	"them", "these", "so", "some", "her", "would", "make", "like", "him", "into", "time", "has", "look",
+	"morning", "evening", "walking", "Holmes", "Watson", "London", "Baker", "street", "letter", "reading",
+};
+#define WORD_COUNT ( sizeof(words) / sizeof(words[0]) )
+
+static const char* methods[] = { "GET", "GET", "GET", "POST", "PUT", "DELETE", "HEAD" };
+static const char* paths[] = { "/", "/index.html", "/api/v1/users", "/static/app.js", "/img/logo.png", "/login", "/search?q=regex" };
+static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+static const char* agents[] = { "Mozilla/5.0 (X11; Linux x86_64)", "curl/8.4.0", "Googlebot/2.1", "python-requests/2.31" };
+static const int statuses[] = { 200, 200, 200, 200, 301, 304, 404, 500 };
+static const char* levels[] = { "debug", "info", "info", "info", "warn", "error" };
+static const char* messages[] = { "request served", "cache miss", "user login", "connection reset by peer", "slow query", "retrying upstream" };
+
+#define PICK( arr ) arr[ brand( sizeof(arr) / sizeof(arr[0]) ) ]
+
+static void gen_apache( Corpus* C, size_t size )
+{
+	char line[ 512 ];
+	bench_seed = 0x1234567;
+	while( C->size < size )
+	{
+		sprintf( line, "%u.%u.%u.%u - - [%02u/%s/2024:%02u:%02u:%02u +0000] \"%s %s HTTP/1.1\" %d %u \"-\" \"%s\"\n",
+			(unsigned) brand( 223 ) + 1, (unsigned) brand( 256 ), (unsigned) brand( 256 ), (unsigned) brand( 254 ) + 1,
+			(unsigned) brand( 28 ) + 1, PICK( months ), (unsigned) brand( 24 ), (unsigned) brand( 60 ), (unsigned) brand( 60 ),
+			PICK( methods ), PICK( paths ), PICK( statuses ), (unsigned) brand( 100000 ), PICK( agents ) );
+		corpus_append( C, line, strlen( line ) );
+	}
+}
+
+static void gen_json( Corpus* C, size_t size )
+{
+	char line[ 512 ];
+	bench_seed = 0x2345678;
+	while( C->size < size )
+	{
+		sprintf( line, "{\"ts\":\"2024-05-%02uT%02u:%02u:%02u.%03uZ\",\"level\":\"%s\",\"user\":%u,\"msg\":\"%s\",\"latency_ms\":%u}\n",
+			(unsigned) brand( 28 ) + 1, (unsigned) brand( 24 ), (unsigned) brand( 60 ), (unsigned) brand( 60 ), (unsigned) brand( 1000 ),
+			PICK( levels ), (unsigned) brand( 50000 ), PICK( messages ), (unsigned) brand( 2000 ) );
+		corpus_append( C, line, strlen( line ) );
+	}
+}
+
+static void gen_english( Corpus* C, size_t size )
+{
+	size_t n = 0;
+	int sentence_start = 1;
+	bench_seed = 0x3456789;
+	while( C->size < size )
+	{
+		char word[ 32 ];
+		strcpy( word, words[ brand( WORD_COUNT ) ] );
+		if( sentence_start && word[0] >= 'a' && word[0] <= 'z' )
+			word[0] = (char) ( word[0] - 'a' + 'A' );
+		corpus_append( C, word, strlen( word ) );
+		sentence_start = brand( 10 ) == 0;
+		if( sentence_start )
+			corpus_append( C, ".", 1 );
+		corpus_append( C, ++n % 12 ? " " : "\n", 1 );
+	}
+}
+
+static void gen_random( Corpus* C, size_t size )
+{
+	char block[ 256 ];
+	int i;
+	bench_seed = 0x456789a;
+	while( C->size < size )
+	{
+		for( i = 0; i < 256; ++i )
+			block[ i ] = (char) brand( 256 );
+		corpus_append( C, block, sizeof(block) );
+	}
+}
+
+static void corpus_init( Corpus* C, const char* name, void (*gen)( Corpus*, size_t ), size_t size )
+{
+	size_t i, beg = 0;
+	memset( C, 0, sizeof(*C) );
+	C->name = name;
+	gen( C, size );
+	
+	for( i = 0; i < C->size; ++i )
+		C->line_count += C->data[ i ] == '\n';
+	C->line_count++;
+	C->lines = (const char**) malloc( sizeof(*C->lines) * C->line_count );
+	C->line_sizes = (size_t*) malloc( sizeof(*C->line_sizes) * C->line_count );
+	C->line_count = 0;
+	for( i = 0; i <= C->size; ++i )
+	{
+		if( i == C->size || C->data[ i ] == '\n' )
+		{
+			C->lines[ C->line_count ] = C->data + beg;
+			C->line_sizes[ C->line_count++ ] = i - beg;
+			beg = i + 1;
+		}
+	}
+}
+
+static void corpus_free( Corpus* C )
+{
+	free( C->data );
+	free( (void*) C->lines );
+	free( C->line_sizes );
+}
+
+
+/* benchmark catalog */
+#define OP_FINDALL 0 /* srx_FindAllCb over the whole corpus */
+#define OP_LINES   1 /* srx_MatchExt on each line */
+#define OP_BATCH   2 /* srx_MatchBatch on all lines */
+#define OP_REPLACE 3 /* srx_ReplaceSink over the whole corpus */
+
+static const char* op_names[] = { "findall", "lines", "batch", "replace" };
+
+typedef struct Bench
+{
+	const char* name;
+	int         corpus;
+	const char* pattern;
+	const char* mods;
+	int         op;
+	const char* rep;
+}
+Bench;
+
+#define C_APACHE  0
+#define C_JSON    1
+#define C_ENGLISH 2
+#define C_RANDOM  3
+
+static const Bench catalog[] =
+{
+	/* literals */
+	{ "literal_get", C_APACHE, "GET", "", OP_FINDALL, NULL },
+	{ "literal_error", C_JSON, "\"level\":\"error\"", "", OP_LINES, NULL },
+	{ "literal_holmes", C_ENGLISH, "Holmes", "", OP_FINDALL, NULL },
+	{ "literal_caseless", C_ENGLISH, "watson", "i", OP_FINDALL, NULL },
+	{ "literal_random", C_RANDOM, "regex", "", OP_FINDALL, NULL },
+	/* classes */
+	{ "class_digits", C_APACHE, "[0-9]+", "", OP_FINDALL, NULL },
+	{ "class_word", C_ENGLISH, "[A-Z][a-z]+", "", OP_FINDALL, NULL },
+	{ "class_ing", C_ENGLISH, "\\w+ing", "", OP_FINDALL, NULL },
+	{ "class_random", C_RANDOM, "[a-z]{3}[0-9]", "", OP_FINDALL, NULL },
+	/* alternations */
+	{ "alt_methods", C_APACHE, "GET|POST|PUT|DELETE", "", OP_FINDALL, NULL },
+	{ "alt_levels", C_JSON, "\"(warn|error|fatal)\"", "", OP_LINES, NULL },
+	{ "alt_words", C_ENGLISH, "Holmes|Watson|London", "", OP_FINDALL, NULL },
+	/* captures */
+	{ "cap_ipv4", C_APACHE, "^(\\d+)\\.(\\d+)\\.(\\d+)\\.(\\d+)", "", OP_LINES, NULL },
+	{ "cap_request", C_APACHE, "\"(\\w+) ([^ ]+) HTTP/([0-9.]+)\"", "", OP_LINES, NULL },
+	{ "cap_user", C_JSON, "\"user\":(\\d+)", "", OP_FINDALL, NULL },
+	{ "cap_date", C_JSON, "(\\d{4})-(\\d{2})-(\\d{2})T", "", OP_FINDALL, NULL },
+	/* batch matching (compare with the lines runs) */
+	{ "batch_error", C_JSON, "\"level\":\"error\"", "", OP_BATCH, NULL },
+	{ "batch_levels", C_JSON, "\"(warn|error|fatal)\"", "", OP_BATCH, NULL },
+	{ "batch_status", C_APACHE, "\" [45]\\d\\d ", "", OP_BATCH, NULL },
+	{ "lines_status", C_APACHE, "\" [45]\\d\\d ", "", OP_LINES, NULL },
+	/* replace */
+	{ "rep_digits", C_APACHE, "\\d+", "", OP_REPLACE, "#" },
+	{ "rep_swap", C_JSON, "\"(\\w+)\":(\\d+)", "", OP_REPLACE, "$2=$1" },
+	{ "rep_ing", C_ENGLISH, "(\\w+)ing", "", OP_REPLACE, "\\1ed" },
+};
+#define BENCH_COUNT ( sizeof(catalog) / sizeof(catalog[0]) )
+
+
+/* operations, each returns the number of matches and adds the API calls made */
+static int count_match( void* userdata, srx_Context* R, const srx_Span* caps, int count )
+{
+	(void) R;
+	(void) caps;
+	(void) count;
+	( *(size_t*) userdata )++;
+	return 0;
+}
+
+static int count_write( void* userdata, const rxChar* data, size_t size )
+{
+	(void) data;
+	*(size_t*) userdata += size;
+	return 0;
+}
+
+static size_t run_op( const Bench* B, srx_Context* R, const srx_Template* T, const Corpus* C, unsigned char* bitmap, size_t* calls )
+{
+	size_t i, matches = 0, written = 0;
+	switch( B->op )
+	{
+	case OP_FINDALL:
+		srx_FindAllCb( R, C->data, C->size, 0, count_match, &matches );
+		*calls += 1;
+		break;
+	case OP_LINES:
+		for( i = 0; i < C->line_count; ++i )
+			matches += (size_t) srx_MatchExt( R, C->lines[ i ], C->line_sizes[ i ], 0 );
+		*calls += C->line_count;
+		break;
+	case OP_BATCH:
+		matches = srx_MatchBatch( R, C->lines, C->line_sizes, C->line_count, bitmap, NULL );
+		*calls += C->line_count;
+		break;
+	case OP_REPLACE:
+		matches = srx_ReplaceSink( R, C->data, C->size, T, count_write, &written );
+		*calls += 1;
+		break;
+	}
+	return matches;
+}
+
+static void run_bench( const Bench* B, const Corpus* C, double min_time )
+{
+	int err[ 2 ];
+	size_t runs = 0, calls = 0, matches, allocs;
+	clock_t start;
+	double seconds;
+	srx_Analysis A;
+	srx_Template* T = NULL;
+	unsigned char* bitmap = (unsigned char*) malloc( C->line_count / 8 + 1 );
+	srx_Context* R = srx_CreateExt( B->pattern, strlen( B->pattern ), B->mods, err, bench_memfn, NULL );
+	
+	if( !R )
+	{
+		fprintf( stderr, "%s: failed to compile '%s' (error %d at %d)\n", B->name, B->pattern, err[0], err[1] );
+		exit( 1 );
+	}
+	srx_Analyze( R, &A );
+	if( B->rep )
+		T = srx_CreateTemplate( R, B->rep );
+	
+	/* warm-up run (first-use allocations, caches) */
+	matches = run_op( B, R, T, C, bitmap, &calls );
+	calls = 0;
+	bench_allocs = 0;
+	start = clock();
+	do
+	{
+		run_op( B, R, T, C, bitmap, &calls );
+		runs++;
+		seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+	}
+	while( seconds < min_time );
+	allocs = bench_allocs;
+	
+	printf( "%s\t%s\t%s\t%s\t%lu\t%lu\t%lu\t%lu\t%.4f\t%.2f\t%.1f\t%.2f\n",
+		B->name, C->name, op_names[ B->op ], srx_EngineName( A.engine ),
+		(unsigned long) C->size, (unsigned long) calls, (unsigned long) matches, (unsigned long) runs, seconds,
+		(double) C->size * (double) runs / seconds / 1e6, seconds * 1e9 / (double) calls, (double) allocs / (double) runs );
+	fflush( stdout );
+	
+	if( T )
+		srx_DestroyTemplate( T );
+	srx_Destroy( R );
+	free( bitmap );
+}
+
+
+int main( int argc, char* argv[] )
+{
+	Corpus corpora[ 4 ];
+	double min_time = 0.2;
+	size_t i, size = 1024 * 1024;
+	const char* filter = NULL;
+	int a;
+	
+	for( a = 1; a < argc; ++a )
+	{
+		if( strcmp( argv[ a ], "-t" ) == 0 && a + 1 < argc )
+			min_time = atof( argv[ ++a ] );
+		else if( strcmp( argv[ a ], "-s" ) == 0 && a + 1 < argc )
+			size = (size_t) atol( argv[ ++a ] ) * 1024;
+		else if( argv[ a ][0] != '-' )
+			filter = argv[ a ];
+		else
+		{
+			fprintf( stderr, "usage: %s [-t <min. seconds per benchmark>] [-s <corpus size in KB>] [name filter]\n", argv[0] );
+			return 1;
+		}
+	}
+	
+	corpus_init( &corpora[ C_APACHE ], "apache", gen_apache, size );
+	corpus_init( &corpora[ C_JSON ], "json", gen_json, size );
+	corpus_init( &corpora[ C_ENGLISH ], "english", gen_english, size );
+	corpus_init( &corpora[ C_RANDOM ], "random", gen_random, size );
+	
+	/* tab-separated, one line per benchmark */
+	printf( "# bench\tcorpus\top\tengine\tbytes\tcalls\tmatches\truns\tseconds\tmb_s\tns_call\tallocs\n" );
+	for( i = 0; i < BENCH_COUNT; ++i )
+	{
+		if( filter && !strstr( catalog[ i ].name, filter ) )
+			continue;
+		run_bench( &catalog[ i ], &corpora[ catalog[ i ].corpus ], min_time );
+	}
+	
+	for( i = 0; i < 4; ++i )
+		corpus_free( &corpora[ i ] );
+	return 0;
+}
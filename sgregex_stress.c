@@ -0,0 +1,184 @@
+
+#include "sgregex.c"
+
+
+/* worst-case latency and memory scaling of matching and compilation */
+
+static double now( void )
+{
+	return (double) clock() / CLOCKS_PER_SEC;
+}
+
+static char* make_string( const char* unit, size_t count, const char* tail )
+{
+	size_t i, ulen = strlen( unit ), tlen = strlen( tail );
+	char* str = (char*) malloc( ulen * count + tlen + 1 );
+	for( i = 0; i < count; ++i )
+		memcpy( str + i * ulen, unit, ulen );
+	memcpy( str + ulen * count, tail, tlen + 1 );
+	return str;
+}
+
+typedef struct MatchCase
+{
+	const char* name;
+	const char* pattern;
+	const char* unit; /* input is `unit` repeated n times, followed by `tail` */
+	const char* tail;
+	size_t      n_min;
+	size_t      n_max;
+	int         doubling; /* double n at each step (otherwise add n_min) */
+}
+MatchCase;
+
+static const MatchCase match_cases[] =
+{
+	/* exponential backtracking */
+	{ "alt_star", "(a|a)*b", "a", "", 2, 64, 0 },
+	{ "plus_plus_end", "(a+)+$", "a", "!", 2, 64, 0 },
+	{ "word_space", "^(\\w+\\s?)+$", "ab", "!", 1, 32, 0 },
+	/* deep nesting */
+	{ "nested_30", "((((((((((((((((((((((((((((((x))))))))))))))))))))))))))))))", "y", "x", 64, 1 << 20, 1 },
+	/* huge counted repeats (a single character is scanned with one state, group iteration counters and states grow with input) */
+	{ "repeat_65535", "a{1,65535}b", "a", "", 64, 1 << 16, 1 },
+	{ "group_repeat_65535", "(ab){1,65535}c", "ab", "", 64, 1 << 15, 1 },
+	/* polynomial */
+	{ "dot_star_twice", "a.*b.*c", "ab", "", 64, 1 << 14, 1 },
+};
+#define MATCH_CASE_COUNT ( sizeof(match_cases) / sizeof(match_cases[0]) )
+
+/* runs the case on growing inputs until the limit or the time budget is reached */
+static void run_match_case( const MatchCase* M, int force_backtrack, double budget )
+{
+	size_t n;
+	srx_Analysis A;
+	srx_Context* R = srx_Create( M->pattern, "" );
+	
+	srx_Analyze( R, &A );
+	srx_Destroy( R );
+	if( force_backtrack && A.engine == RX_ENGINE_BACKTRACK && !( A.flags & RX_AF_ONE_PASS ) )
+		return; /* same as the selected engine */
+	
+	for( n = M->n_min; n <= M->n_max; n = M->doubling ? n * 2 : n + M->n_min )
+	{
+		char* str = make_string( M->unit, n, M->tail );
+		size_t size = strlen( str );
+		double start, seconds;
+		srx_Stats st;
+		int match;
+		
+		/* fresh context, so that stack sizes are those of this input */
+		R = srx_Create( M->pattern, "" );
+		if( force_backtrack )
+		{
+			R->analysis.engine = RX_ENGINE_BACKTRACK;
+			if( R->onepass )
+			{
+				rxFreeOnePass( R, R->onepass );
+				R->onepass = NULL;
+			}
+		}
+		start = now();
+		match = srx_MatchExt( R, str, size, 0 );
+		seconds = now() - start;
+		srx_GetStats( R, &st );
+		
+		printf( "match\t%s\t%s\t%lu\t%.6f\t%lu\t%lu\t%lu\t%lu\t%d\n", M->name, srx_EngineName( R->analysis.engine ),
+			(unsigned long) size, seconds, (unsigned long) st.steps, (unsigned long) st.max_depth,
+			(unsigned long) ( R->states_mem * sizeof(rxState) ), (unsigned long) ( R->iternum_mem * sizeof(uint32_t) ), match );
+		fflush( stdout );
+		srx_Destroy( R );
+		free( str );
+		if( seconds > budget )
+			break;
+	}
+}
+
+/* alternation of `n` distinct words */
+static char* make_alternation( size_t n )
+{
+	size_t i;
+	char* str = (char*) malloc( n * 8 + 1 );
+	char* p = str;
+	for( i = 0; i < n; ++i )
+		p += sprintf( p, i ? "|w%lu" : "w%lu", (unsigned long) i );
+	return str;
+}
+
+/* `n` levels of nested groups around a single character */
+static char* make_nesting( size_t n )
+{
+	char* str = (char*) malloc( n * 2 + 2 );
+	memset( str, '(', n );
+	str[ n ] = 'x';
+	memset( str + n + 1, ')', n );
+	str[ n * 2 + 1 ] = 0;
+	return str;
+}
+
+static void run_compile_case( const char* name, char* (*make)( size_t ), size_t n_min, size_t n_max, double budget )
+{
+	size_t n;
+	for( n = n_min; n <= n_max; n *= 2 )
+	{
+		char* pat = make( n );
+		int err[ 2 ];
+		double start, seconds;
+		size_t instrs = 0;
+		srx_Context* R;
+		
+		start = now();
+		R = srx_CreateExt( pat, strlen( pat ), "", err, NULL, NULL );
+		seconds = now() - start;
+		if( R )
+		{
+			while( R->instrs[ instrs ].op != RX_OP_MATCH_DONE )
+				instrs++;
+			srx_Destroy( R );
+		}
+		printf( "compile\t%s\t-\t%lu\t%.6f\t%lu\t-\t-\t-\t%d\n", name, (unsigned long) strlen( pat ), seconds,
+			(unsigned long) instrs, err[0] );
+		fflush( stdout );
+		free( pat );
+		if( seconds > budget )
+			break;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	double budget = 0.5;
+	size_t i;
+	const char* filter = NULL;
+	int a;
+	
+	for( a = 1; a < argc; ++a )
+	{
+		if( strcmp( argv[ a ], "-t" ) == 0 && a + 1 < argc )
+			budget = atof( argv[ ++a ] );
+		else if( argv[ a ][0] != '-' )
+			filter = argv[ a ];
+		else
+		{
+			fprintf( stderr, "usage: %s [-t <seconds after which a case stops growing>] [name filter]\n", argv[0] );
+			return 1;
+		}
+	}
+	
+	/* tab-separated; match rows report the input size, matcher steps, peak stack depth, stack capacities and the match result,
+	   compile rows report the pattern length, instruction count and error code */
+	printf( "# kind\tcase\tengine\tsize\tseconds\tsteps\tmax_depth\tstates_bytes\titernum_bytes\tresult\n" );
+	for( i = 0; i < MATCH_CASE_COUNT; ++i )
+	{
+		if( filter && !strstr( match_cases[ i ].name, filter ) )
+			continue;
+		run_match_case( &match_cases[ i ], 0, budget );
+		run_match_case( &match_cases[ i ], 1, budget );
+	}
+	if( !filter || strstr( "alternation", filter ) )
+		run_compile_case( "alternation", make_alternation, 1250, 20000, budget );
+	if( !filter || strstr( "nesting", filter ) )
+		run_compile_case( "nesting", make_nesting, 16, 256, budget );
+	return 0;
+}
@@ -16,7 +16,7 @@ static int rxTest2( rxExecute* e, rxInstr* ins, rxChar* chr, const char* s )
 	{
 		if( e->captures[ i ][0] != RX_NULL_OFFSET || e->captures[ i ][1] != RX_NULL_OFFSET )
 		{
-			printf( "  capture group %d: %d - %d\n", i, e->captures[ i ][0], e->captures[ i ][1] );
+			printf( "  capture group %d: %d - %d\n", i, (int) e->captures[ i ][0], (int) e->captures[ i ][1] );
 		}
 	}
 	if( ret == 0 )
@@ -76,7 +76,7 @@ static int rxCompTest2( const char* expr, const char* mods, rxInstr* instrs, siz
 	}
 	else
 	{
-		RX_LOG( rxDumpToFile( c.instrs, c.chars, stdout ) );
+		RX_LOG( rxDumpToFile( c.instrs, c.chars, NULL, stdout ) );
 	}
 	
 	if( instrs )
@@ -187,6 +187,42 @@ void matchtest_ext( const char* mst, const char* pat, const char* mod, int ismat
 #define MATCHTEST( mst, pat, ismatch ) matchtest_ext( mst, pat, NULL, ismatch )
 #define MATCHTEST2( mst, pat, mod, ismatch ) matchtest_ext( mst, pat, mod, ismatch )
 
+typedef struct sinkbuf
+{
+	char data[ 256 ];
+	size_t size;
+}
+sinkbuf;
+
+static int write_sinkbuf( void* userdata, const char* data, size_t size )
+{
+	sinkbuf* sb = (sinkbuf*) userdata;
+	RX_ASSERT( size > 0 && sb->size + size <= sizeof(sb->data) );
+	memcpy( sb->data + sb->size, data, size );
+	sb->size += size;
+	return 0;
+}
+
+/* wraps each match in brackets, uppercases the first capture and stops after `*userdata` matches */
+static int upper_replace( void* userdata, srx_Context* ctx, const srx_Span* caps, int count, srx_WriteFunc write, void* writedata )
+{
+	int* left = (int*) userdata;
+	const char *beg, *end;
+	(void) caps;
+	(void) count;
+	write( writedata, "[", 1 );
+	if( srx_GetCapturedPtrs( ctx, 1, &beg, &end ) )
+	{
+		for( ; beg != end; ++beg )
+		{
+			char ch = (char) ( *beg >= 'a' && *beg <= 'z' ? *beg - 'a' + 'A' : *beg );
+			write( writedata, &ch, 1 );
+		}
+	}
+	write( writedata, "]", 1 );
+	return --*left == 0;
+}
+
 void reptest_ext( const char* mst, const char* pat, const char* mod, const char* rep, const char* res )
 {
 	char* out;
@@ -214,6 +250,21 @@ void reptest_ext( const char* mst, const char* pat, const char* mod, const char*
 	RX_ASSERT( memcmp( out, res, reslen ) == 0 );
 	srx_FreeReplaced( R, out );
 	
+	/* precompiled template with fixed buffer / sink output */
+	{
+		char buf[ 256 ];
+		sinkbuf sb;
+		srx_Template* T = srx_CreateTemplateExt( R, repNNT, replen );
+		RX_ASSERT( srx_ReplaceBuf( R, mstNNT, mstlen, T, buf, sizeof(buf) ) == reslen );
+		RX_ASSERT( strcmp( buf, res ) == 0 );
+		RX_ASSERT( srx_ReplaceBuf( R, mstNNT, mstlen, T, buf, 4 ) == reslen );
+		RX_ASSERT( strlen( buf ) == ( reslen < 3 ? reslen : 3 ) && memcmp( buf, res, strlen( buf ) ) == 0 );
+		sb.size = 0;
+		srx_ReplaceSink( R, mstNNT, mstlen, T, write_sinkbuf, &sb );
+		RX_ASSERT( sb.size == reslen && memcmp( sb.data, res, reslen ) == 0 );
+		srx_DestroyTemplate( T );
+	}
+	
 	if( flags & TEST_DUMP )
 	{
 		srx_DumpToStdout( R );
@@ -228,6 +279,523 @@ void reptest_ext( const char* mst, const char* pat, const char* mod, const char*
 #define REPTEST( mst, pat, rep, res ) reptest_ext( mst, pat, NULL, rep, res )
 #define REPTEST2( mst, pat, mod, rep, res ) reptest_ext( mst, pat, mod, rep, res )
 
+static int collect_matches( void* userdata, srx_Context* ctx, const srx_Span* caps, int count )
+{
+	int i;
+	char* out = (char*) userdata;
+	(void) ctx;
+	out += strlen( out );
+	for( i = 0; i < count; ++i )
+	{
+		out += sprintf( out, i ? " " : "[" );
+		if( caps[ i ].beg == RX_NOPOS )
+			out += sprintf( out, "-" );
+		else
+			out += sprintf( out, "%d-%d", (int) caps[ i ].beg, (int) caps[ i ].end );
+	}
+	sprintf( out, "]" );
+	return 0;
+}
+
+void streamtest_ext( const char* mst, const char* pat, const char* mod, const char* res )
+{
+	char out[ 256 ];
+	size_t chunk, mstlen = strlen( mst );
+	
+	printf( "stream test: '%s' like '%s'", mst, pat );
+	if( mod )
+		printf( "(%s)", mod );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	RX_ASSERT( R );
+	for( chunk = 1; chunk <= mstlen; ++chunk )
+	{
+		size_t i;
+		srx_Stream* S = srx_CreateStream( R, collect_matches, out );
+		out[0] = 0;
+		for( i = 0; i < mstlen; i += chunk )
+			RX_ASSERT( srx_StreamFeed( S, mst + i, i + chunk > mstlen ? mstlen - i : chunk ) );
+		RX_ASSERT( srx_StreamFinish( S ) );
+		srx_DestroyStream( S );
+		if( strcmp( out, res ) != 0 )
+			printf( "\n ^ chunk size %d: got %s\n", (int) chunk, out );
+		RX_ASSERT( strcmp( out, res ) == 0 );
+	}
+	printf( " => %s\n", out );
+	srx_Destroy( R );
+}
+#define STREAMTEST( mst, pat, res ) streamtest_ext( mst, pat, NULL, res )
+#define STREAMTEST2( mst, pat, mod, res ) streamtest_ext( mst, pat, mod, res )
+
+void findtest_ext( const char* mst, const char* pat, const char* mod, const char* res )
+{
+	char out[ 256 ], out2[ 256 ];
+	srx_Span spans[ 64 ];
+	size_t i, count, count2;
+	int ncaps;
+	
+	printf( "find-all test: '%s' like '%s'", mst, pat );
+	if( mod )
+		printf( "(%s)", mod );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	RX_ASSERT( R );
+	ncaps = srx_GetCaptureCount( R );
+	
+	out[0] = 0;
+	count = srx_FindAllCb( R, mst, strlen( mst ), 0, collect_matches, out );
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	
+	out2[0] = 0;
+	count2 = srx_FindAll( R, mst, spans, 64 / (size_t) ncaps );
+	RX_ASSERT( count == count2 );
+	for( i = 0; i < count2; ++i )
+		collect_matches( out2, R, spans + i * (size_t) ncaps, ncaps );
+	RX_ASSERT( strcmp( out, out2 ) == 0 );
+	
+	/* limited output */
+	if( count > 1 )
+	{
+		RX_ASSERT( srx_FindAll( R, mst, spans, 1 ) == 1 );
+		RX_ASSERT( memcmp( spans, spans + ( count - 1 ) * (size_t) ncaps, sizeof(*spans) ) != 0 );
+	}
+	srx_Destroy( R );
+}
+#define FINDTEST( mst, pat, res ) findtest_ext( mst, pat, NULL, res )
+#define FINDTEST2( mst, pat, mod, res ) findtest_ext( mst, pat, mod, res )
+
+void splittest_ext( const char* mst, const char* pat, size_t maxsplits, int sflags, const char* res )
+{
+	char out[ 256 ];
+	char* op = out;
+	srx_Span spans[ 16 ];
+	size_t i, count;
+	
+	printf( "split test: '%s' by '%s'", mst, pat );
+	R = srx_Create( pat, "" );
+	RX_ASSERT( R );
+	count = srx_SplitExt( R, mst, strlen( mst ), spans, 16, maxsplits, sflags );
+	out[0] = 0;
+	for( i = 0; i < count; ++i )
+	{
+		if( spans[ i ].beg == RX_NOPOS )
+			op += sprintf( op, "[-]" );
+		else
+			op += sprintf( op, "[%d-%d]", (int) spans[ i ].beg, (int) spans[ i ].end );
+	}
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	
+	/* limited output still reports the full count */
+	if( count > 1 )
+	{
+		srx_Span first;
+		RX_ASSERT( srx_SplitExt( R, mst, strlen( mst ), &first, 1, maxsplits, sflags ) == count );
+		RX_ASSERT( first.beg == spans[0].beg && first.end == spans[0].end );
+	}
+	srx_Destroy( R );
+}
+#define SPLITTEST( mst, pat, res ) splittest_ext( mst, pat, 0, 0, res )
+
+/* counters of the backtracking matcher are checked on patterns that the one-pass engine would run */
+static srx_Context* no_onepass( srx_Context* ctx )
+{
+	if( ctx->onepass )
+	{
+		rxFreeOnePass( ctx, ctx->onepass );
+		ctx->onepass = NULL;
+	}
+	return ctx;
+}
+
+/* runs tasks in reverse order to make sure that chunks do not depend on each other */
+static void reverse_executor( void* userdata, srx_TaskFunc fn, void** tasks, size_t count )
+{
+	(void) userdata;
+	while( count-- )
+		fn( tasks[ count ] );
+}
+
+void analyzetest_ext( const char* pat, const char* mod, int aflags, int cost, int engine )
+{
+	srx_Analysis A;
+	
+	printf( "analysis test: '%s'", pat );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	RX_ASSERT( R );
+	srx_Analyze( R, &A );
+	printf( " => flags=%02X cost=%d engine=%d min=%d literal=%d depth=%d\n", A.flags, A.cost, A.engine,
+		(int) A.min_length, (int) A.literal_length, (int) A.repeat_depth );
+	RX_ASSERT( A.flags == aflags && A.cost == cost && A.engine == engine );
+	srx_Destroy( R );
+}
+#define ANALYZETEST( pat, flags, cost, engine ) analyzetest_ext( pat, NULL, flags, cost, engine )
+#define ANALYZETEST2( pat, mod, flags, cost, engine ) analyzetest_ext( pat, mod, flags, cost, engine )
+
+/* keeps the last report and counts the calls */
+static srx_SlowInfo slow_last;
+static int slow_count;
+static void record_slow( void* userdata, srx_Context* ctx, const srx_SlowInfo* info )
+{
+	(void) userdata;
+	(void) ctx;
+	slow_last = *info;
+	slow_count++;
+}
+
+/* lowest index of a pattern that matches str[beg;end) entirely, -1 if none */
+static int lex_full_match( srx_Context** full, size_t count, const char* str, size_t beg, size_t end )
+{
+	size_t i;
+	for( i = 0; i < count; ++i )
+	{
+		if( srx_MatchExt( full[ i ], str + beg, end - beg, 0 ) )
+			return (int) i;
+	}
+	return -1;
+}
+
+/* tokenizes `mst`, checking each token against all pattern matches at its position (longest, then the first pattern),
+   patterns with anchors cannot be checked that way (the substring has different ends) */
+void lextest_ext( const char* const* pats, size_t count, const char* mod, int anchors, const char* mst, const char* res )
+{
+	char out[ 512 ], *op = out;
+	size_t i, beg, end, mstlen = strlen( mst );
+	srx_Context* full[ 16 ];
+	srx_Span tok;
+	int id, lerr[ 3 ];
+	srx_Lexer* L = srx_CreateLexer( pats, NULL, count, mod, lerr, NULL, NULL );
+	
+	printf( "lexer test: '%s'", mst );
+	RX_ASSERT( L && lerr[0] == RXSUCCESS );
+	for( i = 0; i < count; ++i )
+	{
+		char fpat[ 128 ];
+		sprintf( fpat, "^(%s)$", pats[ i ] );
+		full[ i ] = srx_Create( fpat, mod );
+	}
+	
+	out[0] = 0;
+	for( beg = 0; beg <= mstlen && !anchors; ++beg )
+	{
+		size_t k;
+		id = srx_LexerMatch( L, mst, mstlen, beg, &end );
+		/* no longer match, no earlier pattern of the same length */
+		for( k = mstlen; k >= beg && k + 1 > 0; --k )
+		{
+			int fid = lex_full_match( full, count, mst, beg, k );
+			if( fid >= 0 )
+			{
+				RX_ASSERT( id == fid && end == k );
+				break;
+			}
+			if( k == beg )
+			{
+				/* srx_MatchExt does not match empty strings */
+				RX_ASSERT( id == -1 || end == beg );
+				break;
+			}
+		}
+	}
+	for( beg = 0; ( id = srx_LexerFind( L, mst, mstlen, beg, &tok ) ) >= 0; beg = tok.end > tok.beg ? tok.end : tok.end + 1 )
+	{
+		RX_ASSERT( tok.beg >= beg && srx_LexerMatch( L, mst, mstlen, tok.beg, &end ) == id && end == tok.end );
+		op += sprintf( op, "%d[%.*s]", id, (int)( tok.end - tok.beg ), mst + tok.beg );
+	}
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	
+	for( i = 0; i < count; ++i )
+		srx_Destroy( full[ i ] );
+	srx_DestroyLexer( L );
+}
+#define LEXTEST( pats, mst, res ) lextest_ext( pats, sizeof(pats) / sizeof(pats[0]), NULL, 0, mst, res )
+#define LEXTEST2( pats, mod, mst, res ) lextest_ext( pats, sizeof(pats) / sizeof(pats[0]), mod, 0, mst, res )
+#define LEXTEST_ANCHORS( pats, mst, res ) lextest_ext( pats, sizeof(pats) / sizeof(pats[0]), NULL, 1, mst, res )
+
+static const char* lex_query[] = { "select|from|where", "[a-z_]\\w*", "\\d+", "\\d+\\.\\d*", "<|<=|<>|=", "'[^']*'", "\\s+" };
+static const char* lex_ties[] = { "ab", "a|ab|abc", "[a-c]+", "b*" };
+static const char* lex_anchors[] = { "^#\\w+", "\\w+$", "\\w+", "." };
+
+void partest_ext( const char* mst, const char* pat, const char* mod )
+{
+	char out[ 512 ], ref[ 512 ];
+	size_t nchunks, mstlen = strlen( mst ), count;
+	
+	printf( "parallel test: '%s' like '%s'", mst, pat );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	RX_ASSERT( R );
+	ref[0] = 0;
+	count = srx_FindAllCb( R, mst, mstlen, 0, collect_matches, ref );
+	for( nchunks = 1; nchunks <= mstlen + 1; ++nchunks )
+	{
+		out[0] = 0;
+		RX_ASSERT( srx_FindAllParallel( R, mst, mstlen, nchunks, reverse_executor, NULL, collect_matches, out ) == count );
+		if( strcmp( out, ref ) != 0 )
+			printf( "\n ^ %d chunks: got %s, expected %s\n", (int) nchunks, out, ref );
+		RX_ASSERT( strcmp( out, ref ) == 0 );
+	}
+	out[0] = 0;
+	RX_ASSERT( srx_FindAllParallel( R, mst, mstlen, 3, NULL, NULL, collect_matches, out ) == count );
+	RX_ASSERT( strcmp( out, ref ) == 0 );
+	printf( " => %s\n", ref );
+	srx_Destroy( R );
+}
+#define PARTEST( mst, pat ) partest_ext( mst, pat, NULL )
+
+static const char* lane_strs[] =
+{
+	"", "a", "ab", "abc", "aab", "abab", "ba", "bba", "2013-01-02", "1999-12-31 ok",
+	"192.168.0.1", "10.0.0.256", "ID-0042", "id-42", "x\ny", "AbC", "hello world",
+	"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", "abcabcabc", "cab", "a-b_c",
+};
+#define LANE_COUNT ( sizeof(lane_strs) / sizeof(lane_strs[0]) )
+
+/* batch matching without captures must agree with srx_MatchExt, whichever engine it uses */
+void lanetest_ext( const char* pat, const char* mod )
+{
+	size_t i, count;
+	unsigned char bitmap[ ( LANE_COUNT + 7 ) / 8 ], bitmap2[ ( LANE_COUNT + 7 ) / 8 ];
+	size_t expected = 0;
+	
+	printf( "lockstep test: '%s'", pat );
+	if( mod )
+		printf( "(%s)", mod );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	RX_ASSERT( R );
+	count = srx_MatchBatch( R, lane_strs, NULL, LANE_COUNT, bitmap, NULL );
+	for( i = 0; i < LANE_COUNT; ++i )
+	{
+		int match = srx_MatchExt( R, lane_strs[ i ], strlen( lane_strs[ i ] ), 0 );
+		if( match != ( ( bitmap[ i / 8 ] >> ( i % 8 ) ) & 1 ) )
+			printf( "\n ^ mismatch on '%s', expected %d\n", lane_strs[ i ], match );
+		RX_ASSERT( match == ( ( bitmap[ i / 8 ] >> ( i % 8 ) ) & 1 ) );
+		expected += (size_t) match;
+	}
+	RX_ASSERT( count == expected );
+	RX_ASSERT( srx_MatchBatchParallel( R, lane_strs, NULL, LANE_COUNT, bitmap2, NULL, 3, reverse_executor, NULL ) == count );
+	RX_ASSERT( memcmp( bitmap, bitmap2, sizeof(bitmap) ) == 0 );
+	printf( " => %d matched\n", (int) count );
+	srx_Destroy( R );
+}
+#define LANETEST( pat ) lanetest_ext( pat, NULL )
+#define LANETEST2( pat, mod ) lanetest_ext( pat, mod )
+
+/* first non-empty leftmost-longest match at or after `pos`, found with the backtracker on each substring */
+static int long_oracle( srx_Context* full, const char* str, size_t size, size_t pos, size_t* pbeg, size_t* pend )
+{
+	size_t beg, k;
+	for( beg = pos; beg < size; ++beg )
+	{
+		for( k = size; k > beg; --k )
+		{
+			if( srx_MatchExt( full, str + beg, k - beg, 0 ) )
+			{
+				*pbeg = beg;
+				*pend = k;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* finds all leftmost-longest matches, checking each against the oracle (patterns without anchors) */
+void longtest_ext( const char* mst, const char* pat, const char* res )
+{
+	char out[ 256 ], fpat[ 128 ];
+	srx_Span spans[ 64 ];
+	size_t i, count, pos = 0, obeg, oend, mstlen = strlen( mst );
+	srx_Context* full;
+	int ncaps;
+	
+	printf( "longest test: '%s' like '%s'", mst, pat );
+	R = srx_CreateExt( pat, strlen( pat ), "l", err, NULL, NULL );
+	RX_ASSERT( R );
+	sprintf( fpat, "^(%s)$", pat );
+	full = srx_Create( fpat, "" );
+	ncaps = srx_GetCaptureCount( R );
+	count = srx_FindAllExt( R, mst, mstlen, 0, spans, 64 / (size_t) ncaps );
+	out[0] = 0;
+	for( i = 0; i < count; ++i )
+	{
+		const srx_Span* m = spans + i * (size_t) ncaps;
+		int found = long_oracle( full, mst, mstlen, pos, &obeg, &oend );
+		if( m->end > m->beg )
+			RX_ASSERT( found && obeg == m->beg && oend == m->end )
+		else /* empty matches cannot be checked, only that no longer one starts earlier */
+			RX_ASSERT( !found || obeg > m->beg )
+		collect_matches( out, R, m, ncaps );
+		pos = m->end == m->beg ? m->end + 1 : m->end;
+	}
+	RX_ASSERT( count == 64 / (size_t) ncaps || !long_oracle( full, mst, mstlen, pos, &obeg, &oend ) );
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	srx_Destroy( full );
+	srx_Destroy( R );
+}
+#define LONGTEST( mst, pat, res ) longtest_ext( mst, pat, res )
+
+/* the last match must be the one at the last offset where srx_MatchAt matches, for every starting offset */
+void lasttest_ext( const char* mst, const char* pat, const char* mod, const char* res )
+{
+	char out[ 256 ];
+	srx_Span caps[ RX_MAX_CAPTURES ];
+	size_t i, pos, off, mstlen = strlen( mst );
+	int ncaps, match = 0;
+	
+	printf( "last match test: '%s' like '%s'", mst, pat );
+	if( mod )
+		printf( "(%s)", mod );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	RX_ASSERT( R );
+	ncaps = srx_GetCaptureCount( R );
+	for( off = mstlen + 1; off-- > 0; )
+	{
+		match = 0;
+		for( pos = mstlen; pos > off && !match; )
+			match = srx_MatchAt( R, mst, mstlen, --pos );
+		for( i = 0; i < (size_t) ncaps; ++i )
+		{
+			if( !srx_GetCaptured( R, (int) i, &caps[ i ].beg, &caps[ i ].end ) )
+				caps[ i ].beg = caps[ i ].end = RX_NOPOS;
+		}
+		RX_ASSERT( srx_MatchLast( R, mst, mstlen, off ) == match );
+		for( i = 0; i < (size_t) ncaps && match; ++i )
+		{
+			size_t beg = RX_NOPOS, end = RX_NOPOS;
+			srx_GetCaptured( R, (int) i, &beg, &end );
+			RX_ASSERT( beg == caps[ i ].beg && end == caps[ i ].end );
+		}
+	}
+	/* output of the search from offset 0 */
+	out[0] = 0;
+	if( match )
+		collect_matches( out, R, caps, ncaps );
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	srx_Destroy( R );
+}
+#define LASTTEST( mst, pat, res ) lasttest_ext( mst, pat, NULL, res )
+#define LASTTEST2( mst, pat, mod, res ) lasttest_ext( mst, pat, mod, res )
+
+/* `mst` after 300 padding characters, long enough for the two-phase search (locating the first match with `engine`),
+   which must find the same match and captures as the backtracking matcher from every offset (the output is the first one) */
+void twophasetest_ext( char pad, const char* mst, const char* pat, const char* mod, int engine, const char* res )
+{
+	char str[ 400 ], out[ 256 ];
+	srx_Span caps[ RX_MAX_CAPTURES ];
+	srx_Context* B;
+	size_t i, off, size = 300 + strlen( mst );
+	int ncaps;
+	
+	printf( "%s test: '%c'x300 '%s' like '%s'", engine == RX_ENGINE_TWO_PHASE ? "two-phase" : "bit-parallel", pad, mst, pat );
+	if( mod )
+		printf( "(%s)", mod );
+	memset( str, pad, 300 );
+	strcpy( str + 300, mst );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	B = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	RX_ASSERT( R && B );
+	RX_ASSERT( R->analysis.engine == RX_ENGINE_TWO_PHASE );
+	R->analysis.engine = engine;
+	B->analysis.engine = RX_ENGINE_BACKTRACK;
+	ncaps = srx_GetCaptureCount( R );
+	for( off = 0; off <= size; ++off )
+	{
+		int match = srx_MatchExt( B, str, size, off );
+		RX_ASSERT( srx_MatchExt( R, str, size, off ) == match );
+		for( i = 0; i < (size_t) ncaps && match; ++i )
+		{
+			size_t beg = RX_NOPOS, end = RX_NOPOS;
+			caps[ i ].beg = caps[ i ].end = RX_NOPOS;
+			srx_GetCaptured( R, (int) i, &caps[ i ].beg, &caps[ i ].end );
+			srx_GetCaptured( B, (int) i, &beg, &end );
+			RX_ASSERT( beg == caps[ i ].beg && end == caps[ i ].end );
+		}
+	}
+	out[0] = 0;
+	if( srx_MatchExt( R, str, size, 0 ) )
+	{
+		for( i = 0; i < (size_t) ncaps; ++i )
+		{
+			if( !srx_GetCaptured( R, (int) i, &caps[ i ].beg, &caps[ i ].end ) )
+				caps[ i ].beg = caps[ i ].end = RX_NOPOS;
+		}
+		collect_matches( out, R, caps, ncaps );
+	}
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	srx_Destroy( B );
+	srx_Destroy( R );
+}
+#define TWOPHASETEST( pad, mst, pat, res ) twophasetest_ext( pad, mst, pat, NULL, RX_ENGINE_TWO_PHASE, res )
+#define TWOPHASETEST2( pad, mst, pat, mod, res ) twophasetest_ext( pad, mst, pat, mod, RX_ENGINE_TWO_PHASE, res )
+#define BITPARTEST( pad, mst, pat, res ) twophasetest_ext( pad, mst, pat, NULL, RX_ENGINE_BIT_PARALLEL, res )
+#define BITPARTEST2( pad, mst, pat, mod, res ) twophasetest_ext( pad, mst, pat, mod, RX_ENGINE_BIT_PARALLEL, res )
+
+/* the one-pass engine (if `onepass` expects it to be used) must find the same matches and captures
+   as the backtracking matcher at every offset, the output is all matches */
+void onepasstest_ext( const char* mst, const char* pat, const char* mod, int onepass, const char* res )
+{
+	char out[ 256 ];
+	srx_Context* B;
+	size_t i, off, mstlen = strlen( mst );
+	int ncaps, which;
+	
+	printf( "one-pass test: '%s' like '%s'", mst, pat );
+	if( mod )
+		printf( "(%s)", mod );
+	R = srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL );
+	B = no_onepass( srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL ) );
+	RX_ASSERT( R && B );
+	RX_ASSERT( ( R->onepass != NULL ) == onepass );
+	ncaps = srx_GetCaptureCount( R );
+	for( off = 0; off <= mstlen; ++off )
+	{
+		for( which = 0; which < 2; ++which )
+		{
+			int match = which ? srx_MatchExt( B, mst, mstlen, off ) : srx_MatchAt( B, mst, mstlen, off );
+			RX_ASSERT( ( which ? srx_MatchExt( R, mst, mstlen, off ) : srx_MatchAt( R, mst, mstlen, off ) ) == match );
+			for( i = 0; i < (size_t) ncaps && match; ++i )
+			{
+				size_t beg = RX_NOPOS, end = RX_NOPOS, beg2 = RX_NOPOS, end2 = RX_NOPOS;
+				srx_GetCaptured( R, (int) i, &beg, &end );
+				srx_GetCaptured( B, (int) i, &beg2, &end2 );
+				RX_ASSERT( beg == beg2 && end == end2 );
+			}
+		}
+	}
+	out[0] = 0;
+	srx_FindAllCb( R, mst, mstlen, 0, collect_matches, out );
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	srx_Destroy( B );
+	srx_Destroy( R );
+}
+#define ONEPASSTEST( mst, pat, onepass, res ) onepasstest_ext( mst, pat, NULL, onepass, res )
+#define ONEPASSTEST2( mst, pat, mod, onepass, res ) onepasstest_ext( mst, pat, mod, onepass, res )
+
+/* repeats of single characters are matched by the backtracking matcher without any repeat counters */
+void counttest_ext( const char* mst, const char* pat, const char* mod, const char* res )
+{
+	char out[ 256 ];
+	
+	printf( "counted repeat test: '%s' like '%s'", mst, pat );
+	if( mod )
+		printf( "(%s)", mod );
+	R = no_onepass( srx_CreateExt( pat, strlen( pat ), mod, err, NULL, NULL ) );
+	RX_ASSERT( R );
+	R->analysis.engine = RX_ENGINE_BACKTRACK;
+	out[0] = 0;
+	srx_FindAllCb( R, mst, strlen( mst ), 0, collect_matches, out );
+	printf( " => %s\n", out );
+	RX_ASSERT( strcmp( out, res ) == 0 );
+	RX_ASSERT( R->iternum_mem == 0 );
+	srx_Destroy( R );
+}
+#define COUNTTEST( mst, pat, res ) counttest_ext( mst, pat, NULL, res )
+#define COUNTTEST2( mst, pat, mod, res ) counttest_ext( mst, pat, mod, res )
+
 
 int main()
 {
@@ -672,6 +1240,13 @@ int main()
 	printf( "\n> replacement tests\n\n" );
 	REPTEST( "some *special* text", "\\*.*?\\*", "SpEcIaL", "some SpEcIaL text" );
 	REPTEST( "some *special* text", "\\*(.*?)\\*", "<b>\\1</b>", "some <b>special</b> text" );
+	REPTEST( "ab", "x*", "-", "-a-b" );
+	REPTEST( "aaa", "^a", "X", "Xaa" );
+	/* one pass over the whole string: 1.2 gave "XX", "---" and "---" */
+	REPTEST( "a1a2", "^a\\d", "X", "Xa2" );
+	REPTEST( "baaac", "a*", "-", "-b--c" );
+	REPTEST( "abc", "b*", "-", "-a--c" );
+	REPTEST( "a1b2", "(\\d)", "<$1$2$$>", "a<1$>b<2$>" );
 	
 	printf( "\n> modifier tests\n\n" );
 	/* modifier - 'i' */
@@ -739,6 +1314,18 @@ int main()
 		"(`.*)!(.*`)", "$1-~EXCL~-$2",
 		"|`     -~EXCL~- A      `|" );
 	MATCHTEST( " aaa = 0,", "(a+)( +)?,", 0 );
+	MATCHTEST( "ab", "^(a|b){2}$", 1 );
+	FINDTEST( "abbc", "(a|b){2}c", "[1-4 2-3]" );
+	FINDTEST( "GET x POST", "GET|POST", "[0-3][6-10]" );
+	/* the first branch used to jump past the final capture end (assertion failure) */
+	FINDTEST( "a bc", "a|bc", "[0-1][2-4]" );
+	FINDTEST( "ab1 ab", "ab(1)?", "[0-3 2-3][4-6 -]" );
+	MATCHTEST( "aa1x", "(a\\d?)*$", 0 );
+	/* alternation exits used to push repeat counters (no match) */
+	MATCHTEST( "bac", "^(a|b){2}c$", 1 );
+	/* groups after two literal characters used to start their capture only once (2-4, 2-5) */
+	FINDTEST( "abcc", "ab(c)+", "[0-4 3-4]" );
+	FINDTEST( "abcdce", "ab(c|d)*e", "[0-6 4-5]" );
 	MATCHTEST( ", asdf qwe = 0,", " +([a-zA-Z0-9_*& ]+?) +([a-zA-Z0-9_]+)( += +)?,", 0 );
 	
 	/* http://www.regexlib.com/REDetails.aspx?regexp_id=75 */
@@ -764,6 +1351,605 @@ int main()
 		"m0='\\0' m1='\\1' m2='\\2'",
 		"m0='SGS_PROPERTY float x;' m1='SGS_PROPERTY' m2=' float x'" );
 	
+	printf( "\n> callback replace tests\n\n" );
+	R = srx_Create( "<([a-z]*)>", "" );
+	{
+		size_t outsize;
+		sinkbuf sb;
+		int left = 100;
+		char* out = srx_ReplaceCbExt( R, SLB( "x <ab> y <> z <cd>" ), upper_replace, &left, &outsize );
+		printf( "callback replace => '%s'\n", out );
+		RX_ASSERT( outsize == 18 && strcmp( out, "x [AB] y [] z [CD]" ) == 0 );
+		srx_FreeReplaced( R, out );
+		
+		left = 1;
+		sb.size = 0;
+		RX_ASSERT( srx_ReplaceCbSink( R, SLB( "x <ab> y <> z <cd>" ), upper_replace, &left, write_sinkbuf, &sb ) == 1 );
+		RX_ASSERT( sb.size == 18 && memcmp( sb.data, "x [AB] y <> z <cd>", 18 ) == 0 );
+	}
+	srx_Destroy( R );
+	puts( "" );
+	
+	printf( "\n> find-all tests\n\n" );
+	FINDTEST( "a cat and a hat", "[ch]at", "[2-5][12-15]" );
+	FINDTEST( "x=1, y=22", "(\\w)=(\\d+)", "[0-3 0-1 2-3][5-9 5-6 7-9]" );
+	FINDTEST( "ab", "x*", "[0-0][1-1]" );
+	FINDTEST( "aab", "a*", "[0-2][2-2]" );
+	FINDTEST( "abab", "^ab", "[0-2]" );
+	FINDTEST( "a1b", "(\\d)|([a-z])", "[0-1 - 0-1][1-2 1-2 -][2-3 - 2-3]" );
+	FINDTEST( "none", "x", "" );
+	
+	printf( "\n> split tests\n\n" );
+	SPLITTEST( "a, b,c", ",\\s*", "[0-1][3-4][5-6]" );
+	SPLITTEST( ",a,", ",", "[0-0][1-2][3-3]" );
+	SPLITTEST( "abc", "x*", "[0-3]" );
+	SPLITTEST( "", ",", "[0-0]" );
+	splittest_ext( "a, b,c", ",\\s*", 1, 0, "[0-1][3-6]" );
+	splittest_ext( "1+2-3", "([+-])", 0, RX_SPLIT_CAPTURES, "[0-1][1-2][2-3][3-4][4-5]" );
+	splittest_ext( "a1bxc", "(x)|1", 0, RX_SPLIT_CAPTURES, "[0-1][-][2-3][3-4][4-5]" );
+	
+	printf( "\n> parallel find-all tests\n\n" );
+	PARTEST( "aaa b aaaa ba", "a+" );
+	PARTEST( "abbabab", "ab|b" );
+	PARTEST( "xaxbx", "x*" );
+	PARTEST( "a..b a. .b ab", "a.*?b" );
+	PARTEST( "k1=v1;k2=v2;;k3=", "(\\w+)=(\\w*)" );
+	PARTEST( "abab", "^ab|b$" );
+	PARTEST( "none", "x" );
+	
+	printf( "\n> batch tests\n\n" );
+	{
+		static const char* strs[] =
+		{
+			"2013-01-02", "x", "1999-12-31 ok", "", "99-1-1", "0000-00-00",
+			"a2013-01-02", "2013-01-0", "2020-02-20", "-", "1-2-3", "2000-01-01",
+		};
+		size_t sizes[ 12 ], ntasks;
+		unsigned char bitmap[ 2 ], bitmap2[ 2 ];
+		srx_Span caps[ 12 * 2 ], caps2[ 12 * 2 ];
+		R = srx_Create( "\\d{4}-\\d\\d-(\\d\\d)", "" );
+		for( i = 0; i < 12; ++i )
+			sizes[ i ] = strlen( strs[ i ] );
+		
+		RX_ASSERT( srx_MatchBatch( R, strs, sizes, 12, bitmap, caps ) == 6 );
+		printf( "batch bitmap: %02X %02X\n", bitmap[0], bitmap[1] );
+		RX_ASSERT( bitmap[0] == 0x65 && bitmap[1] == 0x09 );
+		for( i = 0; i < 12; ++i )
+		{
+			int match = srx_Match( R, strs[ i ], 0 );
+			size_t beg = RX_NOPOS, end = RX_NOPOS;
+			srx_GetCaptured( R, 1, &beg, &end );
+			RX_ASSERT( match == ( ( bitmap[ i / 8 ] >> ( i % 8 ) ) & 1 ) );
+			RX_ASSERT( caps[ i * 2 + 1 ].beg == beg && caps[ i * 2 + 1 ].end == end );
+		}
+		
+		for( ntasks = 1; ntasks <= 4; ++ntasks )
+		{
+			memset( caps2, 0xff, sizeof(caps2) );
+			RX_ASSERT( srx_MatchBatchParallel( R, strs, NULL, 12, bitmap2, caps2, ntasks, reverse_executor, NULL ) == 6 );
+			RX_ASSERT( memcmp( bitmap, bitmap2, 2 ) == 0 );
+			RX_ASSERT( memcmp( caps, caps2, sizeof(caps) ) == 0 );
+		}
+		RX_ASSERT( srx_MatchBatch( R, strs, NULL, 12, NULL, NULL ) == 6 );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> lockstep batch tests\n\n" );
+	LANETEST( "\\d{4}-\\d\\d-\\d\\d" );
+	LANETEST( "^\\d{4}-\\d\\d-\\d\\d$" );
+	LANETEST( "^(\\d{1,3}\\.){3}\\d{1,3}$" );
+	LANETEST( "^(25[0-5]|2[0-4]\\d|1?\\d?\\d)(\\.(25[0-5]|2[0-4]\\d|1?\\d?\\d)){3}$" );
+	LANETEST2( "^id-0*42$", "i" );
+	LANETEST( "(a|b){2}" );
+	LANETEST( "^(a|b)*c?$" );
+	LANETEST( "a+?b" );
+	LANETEST( "b$" );
+	LANETEST( "^$" );
+	LANETEST( "x*" );
+	LANETEST( "x{20,}" );
+	LANETEST( "(abc){2,3}" );
+	LANETEST( "[^a-c]" );
+	LANETEST( "x.y" );
+	LANETEST2( "x.y", "s" );
+	LANETEST( "\\w+ \\w+" );
+	LANETEST( "(a)b\\1" );
+	LANETEST2( "^y", "m" );
+	/* all lanes reach the dead state early, the remaining lanes finish alone */
+	LANETEST( "\\w\\w" );
+	LANETEST( "(ab|ba)+$" );
+	
+	printf( "\n> stream tests\n\n" );
+	STREAMTEST( "a cat and a hat", "[ch]at", "[2-5][12-15]" );
+	STREAMTEST( "aaa b aa", "a+", "[0-3][6-8]" );
+	STREAMTEST( "x=1, y=22", "(\\w)=(\\d+)", "[0-3 0-1 2-3][5-9 5-6 7-9]" );
+	STREAMTEST( "abab", "^ab", "[0-2]" );
+	STREAMTEST( "abab", "ab$", "[2-4]" );
+	STREAMTEST( "abab", "(ab)*", "[0-4 2-4]" );
+	STREAMTEST( "<a>text</a>", "<([a-z]+)>.*?</\\1>", "[0-11 1-2]" );
+	STREAMTEST2( "l1\r\nl2\nx", "^l\\d$", "m", "[0-2][2-6]" );
+	STREAMTEST( "none", "x", "" );
+	printf( "long pending match fed byte by byte: " );
+	{
+		char out[ 64 ];
+		size_t k;
+		srx_Stats st;
+		srx_Stream* S;
+		/* the anchored DFA follows the attempt, the backtracker only runs again when it dies */
+		R = srx_Create( "(ab)+", "" );
+		S = srx_CreateStream( R, collect_matches, out );
+		out[0] = 0;
+		for( k = 0; k < 20000; ++k )
+			RX_ASSERT( srx_StreamFeed( S, k % 2 ? "b" : "a", 1 ) );
+		RX_ASSERT( out[0] == 0 );
+		RX_ASSERT( srx_StreamFeed( S, "x", 1 ) && strcmp( out, "[0-20000 19998-20000]" ) == 0 );
+		RX_ASSERT( srx_StreamFinish( S ) );
+		srx_DestroyStream( S );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.steps < 20000 * 4 );
+		srx_Destroy( R );
+		/* without a DFA (backreference), the attempt is retried once the data since its start has doubled */
+		R = srx_Create( "(a)(b\\1)*x", "" );
+		S = srx_CreateStream( R, collect_matches, out );
+		out[0] = 0;
+		for( k = 0; k < 20001; ++k )
+			RX_ASSERT( srx_StreamFeed( S, k % 2 ? "b" : "a", 1 ) );
+		RX_ASSERT( srx_StreamFeed( S, "x", 1 ) && srx_StreamFinish( S ) && strcmp( out, "[0-20002 0-1 19999-20001]" ) == 0 );
+		srx_DestroyStream( S );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.steps < 20000 * 16 );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> stats tests\n\n" );
+	R = no_onepass( srx_Create( "b+", "" ) );
+	{
+		srx_Stats st;
+		char out[ 64 ] = "";
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.calls == 0 && st.bytes == 0 && st.starts == 0 && st.matches == 0 );
+		RX_ASSERT( srx_Match( R, "aabbb", 0 ) == 1 );
+		srx_GetStats( R, &st );
+		printf( "stats: calls=%d bytes=%d starts=%d matches=%d backtracks=%d max_depth=%d reallocs=%d\n",
+			(int) st.calls, (int) st.bytes, (int) st.starts, (int) st.matches,
+			(int) st.backtracks, (int) st.max_depth, (int) st.reallocs );
+		RX_ASSERT( st.calls == 1 && st.bytes == 5 && st.starts == 3 && st.matches == 1 );
+		/* the repeated character is scanned at once, nothing to backtrack into */
+		RX_ASSERT( st.backtracks == 0 && st.max_depth == 4 && st.reallocs == 1 );
+		
+		RX_ASSERT( srx_FindAllCb( R, SLB( "b ab bb" ), 0, collect_matches, out ) == 3 );
+		RX_ASSERT( srx_FindAllParallel( R, SLB( "b ab bb" ), 3, reverse_executor, NULL, collect_matches, out ) == 3 );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.calls == 3 && st.bytes == 5 + 7 + 7 && st.matches == 7 );
+		
+		srx_ResetStats( R );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.calls == 0 && st.starts == 0 && st.max_depth == 0 );
+	}
+	srx_Destroy( R );
+	printf( "prefilter stats: " );
+	{
+		char str[ 400 ];
+		srx_Stats st;
+		memset( str, '-', 400 );
+		memcpy( str + 300, "xaby", 4 );
+		/* the DFA prefilter rejects inputs without a match */
+		R = srx_Create( "^(a+)+b", "" );
+		RX_ASSERT( !srx_Match( R, "aaaa", 0 ) && srx_Match( R, "aab", 0 ) && !srx_Match( R, "b", 0 ) );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.prefilter_calls == 3 && st.prefilter_rejects == 2 && st.prefilter_skipped == 0 );
+		srx_Destroy( R );
+		/* the two-phase search skips the offsets before the first match, its search DFA then screens short inputs too */
+		R = srx_Create( "x(ab|cd)+y", "" );
+		RX_ASSERT( srx_MatchExt( R, str, 400, 0 ) && !srx_MatchExt( R, str, 300, 0 ) && srx_Match( R, "xaby", 0 ) );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.prefilter_calls == 3 && st.prefilter_rejects == 1 && st.prefilter_skipped == 300 );
+		srx_ResetStats( R );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.prefilter_calls == 0 && st.prefilter_rejects == 0 && st.prefilter_skipped == 0 );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> profile tests\n\n" );
+	R = no_onepass( srx_Create( "a+b", "" ) );
+	{
+		srx_InstrProfile prof;
+		RX_ASSERT( srx_Match( R, "aac", 0 ) == 0 );
+#ifdef RX_PROFILE
+		srx_DumpToStdout( R );
+		RX_ASSERT( srx_GetProfile( R, 4, &prof ) );
+		RX_ASSERT( prof.exec == 3 && prof.match == 0 && prof.fail == 3 && prof.backtrack == 0 );
+		/* the repeat runs in its entry jump, one state for all counts of "a" */
+		RX_ASSERT( srx_GetProfile( R, 1, &prof ) );
+		RX_ASSERT( prof.exec == 4 && prof.match == 3 && prof.fail == 1 && prof.backtrack == 1 && prof.peak_states == 2 );
+		RX_ASSERT( srx_GetProfile( R, 3, &prof ) && prof.exec == 0 );
+		RX_ASSERT( !srx_GetProfile( R, 7, &prof ) );
+		srx_ResetProfile( R );
+		RX_ASSERT( srx_GetProfile( R, 0, &prof ) && prof.exec == 0 );
+#else
+		RX_ASSERT( srx_GetProfile( R, 0, &prof ) == 0 );
+#endif
+	}
+	srx_Destroy( R );
+	puts( "" );
+	
+	printf( "\n> analysis tests\n\n" );
+	ANALYZETEST( "hello", RX_AF_LITERAL | RX_AF_AUTOMATON | RX_AF_ONE_PASS, RX_COST_LINEAR, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "^a(b|c)d$", RX_AF_ANCHORED_START | RX_AF_ANCHORED_END | RX_AF_AUTOMATON | RX_AF_ONE_PASS, RX_COST_LINEAR, RX_ENGINE_REVERSE );
+	ANALYZETEST2( "^ab$", "m", 0, RX_COST_LINEAR, RX_ENGINE_BACKTRACK );
+	ANALYZETEST( "(a)b\\1", RX_AF_BACKREF, RX_COST_LINEAR, RX_ENGINE_BACKTRACK );
+	ANALYZETEST( "x(ab|cd)+y", RX_AF_AUTOMATON | RX_AF_ONE_PASS, RX_COST_LINEAR, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "\\d+\\.\\d+", RX_AF_AUTOMATON | RX_AF_ONE_PASS, RX_COST_POLYNOMIAL, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "^a.*b.*c", RX_AF_ANCHORED_START | RX_AF_AUTOMATON, RX_COST_POLYNOMIAL, RX_ENGINE_BACKTRACK );
+	ANALYZETEST( "^(a+b)+$", RX_AF_ANCHORED_START | RX_AF_ANCHORED_END | RX_AF_AUTOMATON | RX_AF_ONE_PASS, RX_COST_LINEAR, RX_ENGINE_REVERSE );
+	ANALYZETEST( "^(a+){3}$", RX_AF_NESTED_REPEAT | RX_AF_ANCHORED_START | RX_AF_ANCHORED_END | RX_AF_AUTOMATON, RX_COST_POLYNOMIAL, RX_ENGINE_REVERSE );
+	ANALYZETEST( "(a+)+b", RX_AF_NESTED_REPEAT | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "^(\\w+\\s?)+$", RX_AF_NESTED_REPEAT | RX_AF_ANCHORED_START | RX_AF_ANCHORED_END | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_REVERSE );
+	ANALYZETEST( "(.*)*x", RX_AF_NESTED_REPEAT | RX_AF_EMPTY_REPEAT | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "(a|ab)*c", RX_AF_AMBIGUOUS_ALT | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "(a{1,4})*b", RX_AF_NESTED_REPEAT | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "(.{1,4})*", RX_AF_NESTED_REPEAT | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST( "^(a(.{1,4})*c)$", RX_AF_NESTED_REPEAT | RX_AF_ANCHORED_START | RX_AF_ANCHORED_END | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_REVERSE );
+	ANALYZETEST( "(\\d{1,3}\\.){3}\\d{1,3}", RX_AF_AUTOMATON | RX_AF_ONE_PASS, RX_COST_POLYNOMIAL, RX_ENGINE_TWO_PHASE );
+	ANALYZETEST2( "(a+)+b", "y", RX_AF_NESTED_REPEAT | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_BACKTRACK );
+	ANALYZETEST( "(a+)+\\1", RX_AF_NESTED_REPEAT | RX_AF_BACKREF, RX_COST_EXPONENTIAL, RX_ENGINE_BACKTRACK );
+	R = srx_Create( "(a+)+b", "" );
+	{
+		srx_Analysis A;
+		size_t cb, ce;
+		srx_Analyze( R, &A );
+		RX_ASSERT( A.min_length == 2 && A.literal_length == 2 && A.repeat_depth == 2 );
+		/* 2^40 paths for the backtracking matcher alone */
+		RX_ASSERT( srx_Match( R, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 0 ) == 0 );
+		RX_ASSERT( srx_Match( R, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 5 ) == 0 );
+		RX_ASSERT( srx_Match( R, "xaab", 1 ) == 1 );
+		RX_ASSERT( srx_GetCaptured( R, 0, &cb, &ce ) && cb == 1 && ce == 4 );
+		RX_ASSERT( strcmp( srx_EngineName( A.engine ), "two_phase" ) == 0 );
+	}
+	srx_Destroy( R );
+	/* bounded repeats with a variable count blow up too when repeated, the DFAs reject the input on their own */
+	R = srx_Create( "(a{1,4})*b", "" );
+	{
+		srx_Stats st;
+		RX_ASSERT( srx_Match( R, "aaaaaaaaaaaaaaaaaaaaaaaa", 0 ) == 0 );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.steps == 0 );
+		RX_ASSERT( srx_Match( R, "aaaaab", 0 ) == 1 );
+	}
+	srx_Destroy( R );
+	RX_ASSERT( strcmp( srx_EngineName( RX_ENGINE_BACKTRACK ), "backtrack" ) == 0 );
+	RX_ASSERT( strcmp( srx_EngineName( RX_ENGINE_BIT_PARALLEL ), "bit_parallel" ) == 0 );
+	RX_ASSERT( strcmp( srx_EngineName( RX_ENGINE_BIT_PARALLEL + 1 ), "unknown" ) == 0 );
+	RX_ASSERT( strcmp( srx_EngineName( -1 ), "unknown" ) == 0 );
+	puts( "" );
+	
+	printf( "\n> slow match tests\n\n" );
+	R = no_onepass( srx_Create( "(a|b)*c", "" ) );
+	{
+		char* out;
+		srx_Stats st;
+		srx_SetSlowCallback( R, 100, 0, record_slow, NULL );
+		RX_ASSERT( srx_Match( R, "abc", 0 ) == 1 );
+		RX_ASSERT( slow_count == 0 );
+		RX_ASSERT( srx_MatchExt( R, "xabababab", 9, 1 ) == 0 );
+		printf( "slow: steps=%d max_depth=%d\n", (int) slow_last.steps, (int) slow_last.max_depth );
+		RX_ASSERT( slow_count == 1 );
+		RX_ASSERT( slow_last.pattern_size == 7 && strcmp( slow_last.pattern, "(a|b)*c" ) == 0 );
+		RX_ASSERT( slow_last.size == 9 && slow_last.offset == 1 && slow_last.steps > 100 );
+		RX_ASSERT( slow_last.max_depth > 0 && slow_last.seconds == 0 );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.steps > slow_last.steps && st.max_depth == slow_last.max_depth );
+		
+		out = srx_Replace( R, "ababababx", "-" );
+		RX_ASSERT( slow_count == 2 && slow_last.offset == 0 && slow_last.size == 9 );
+		srx_FreeReplaced( R, out );
+		
+		srx_SetSlowCallback( R, 0, 0, NULL, NULL );
+		RX_ASSERT( srx_MatchExt( R, "xabababab", 9, 1 ) == 0 );
+		RX_ASSERT( slow_count == 2 );
+	}
+	srx_Destroy( R );
+	puts( "" );
+	
+	printf( "\n> lexer tests\n\n" );
+	LEXTEST( lex_query, "select a1,b from t where x<=12.5 and y<>'it''s'", "0[select]6[ ]1[a1]1[b]6[ ]0[from]6[ ]1[t]6[ ]0[where]6[ ]1[x]4[<=]3[12.5]6[ ]1[and]6[ ]1[y]4[<>]5['it']5['s']" );
+	LEXTEST( lex_query, "selected fromage 7.", "1[selected]6[ ]1[fromage]6[ ]3[7.]" );
+	LEXTEST2( lex_query, "i", "SELECT X", "0[SELECT]6[ ]1[X]" );
+	LEXTEST( lex_ties, "abcab bbx ab", "2[abcab]3[]2[bb]3[]3[]0[ab]" );
+	LEXTEST_ANCHORS( lex_anchors, "#top x#y", "0[#top]3[ ]2[x]3[#]1[y]" );
+	{
+		const char* pats[] = { "a+", "(a)\\1", "(b" };
+		size_t sizes[] = { 2, 5, 2 };
+		int lerr[ 3 ];
+		size_t end = 99;
+		srx_Lexer* L;
+		
+		RX_ASSERT( srx_CreateLexer( pats, sizes, 3, NULL, lerr, NULL, NULL ) == NULL );
+		RX_ASSERT( lerr[0] == RXEAUTO && lerr[2] == 1 );
+		pats[1] = "b)";
+		RX_ASSERT( srx_CreateLexer( pats, NULL, 2, NULL, lerr, NULL, NULL ) == NULL );
+		RX_ASSERT( lerr[0] == RXEUNEXP && lerr[1] == 1 && lerr[2] == 1 );
+		RX_ASSERT( srx_CreateLexer( pats, NULL, 1, "x", lerr, NULL, NULL ) == NULL && lerr[0] == RXEINMOD && lerr[2] == 0 );
+		RX_ASSERT( srx_CreateLexer( pats, NULL, 0, NULL, lerr, NULL, NULL ) == NULL && lerr[0] == RXEEMPTY && lerr[2] == -1 );
+		pats[1] = "^b";
+		RX_ASSERT( srx_CreateLexer( pats, NULL, 2, "m", lerr, NULL, NULL ) == NULL && lerr[0] == RXEAUTO && lerr[2] == 1 );
+		
+		/* sticky: no scan past the offset, explicit sizes */
+		L = srx_CreateLexer( pats, sizes, 1, NULL, NULL, NULL, NULL );
+		RX_ASSERT( srx_LexerMatch( L, "baaab", 5, 0, &end ) == -1 && end == 99 );
+		RX_ASSERT( srx_LexerMatch( L, "baaab", 5, 1, &end ) == 0 && end == 4 );
+		RX_ASSERT( srx_LexerMatch( L, "baaab", 3, 1, &end ) == 0 && end == 3 );
+		RX_ASSERT( srx_LexerMatch( L, "baaab", 5, 6, &end ) == -1 );
+		srx_DestroyLexer( L );
+	}
+	puts( "" );
+	
+	printf( "\n> sticky tests\n\n" );
+	MATCHTEST2( "ab", "b", "y", 0 );
+	MATCHTEST2( "ba", "b", "y", 1 );
+	FINDTEST2( "aaba ab", "a|b", "y", "[0-1][1-2][2-3][3-4]" );
+	FINDTEST2( "xab", "a", "y", "" );
+	REPTEST2( "1,2,x,3", "\\d,", "y", "#", "##x,3" );
+	partest_ext( "aaba ab", "a|b", "y" );
+	LANETEST2( "(a|b)*c", "y" );
+	LANETEST2( "a", "y" );
+	printf( "match at: " );
+	{
+		size_t cbeg, cend;
+		srx_Stats st;
+		
+		R = srx_Create( "^(a+)$", "" );
+		RX_ASSERT( srx_MatchAt( R, SLB( "aa" ), 0 ) );
+		RX_ASSERT( !srx_MatchAt( R, SLB( "baa" ), 1 ) ); /* "^" sees the text before the offset */
+		srx_Destroy( R );
+		R = srx_Create( "^(a+)$", "m" );
+		RX_ASSERT( srx_MatchAt( R, SLB( "b\naa" ), 1 ) ); /* multiline "^" starts at the line break, like in searches */
+		RX_ASSERT( srx_GetCaptured( R, 1, &cbeg, &cend ) && cbeg == 2 && cend == 4 );
+		RX_ASSERT( !srx_MatchAt( R, SLB( "b\naa" ), 3 ) );
+		RX_ASSERT( !srx_MatchAt( R, SLB( "b\naa" ), 0 ) ); /* no search, even without "y" */
+		RX_ASSERT( !srx_MatchAt( R, SLB( "b\naa" ), 5 ) );
+		srx_Destroy( R );
+		
+		R = srx_Create( "a*$", "" );
+		RX_ASSERT( srx_MatchAt( R, SLB( "ba" ), 2 ) ); /* empty match at the end */
+		RX_ASSERT( srx_GetCaptured( R, 0, &cbeg, &cend ) && cbeg == 2 && cend == 2 );
+		RX_ASSERT( srx_MatchAt( R, SLB( "ba" ), 1 ) && !srx_MatchAt( R, SLB( "ba" ), 0 ) );
+		srx_Destroy( R );
+		
+		/* the exponential pattern would get the DFA prefilter without "y" */
+		R = srx_Create( "(a|a)*b", "y" );
+		RX_ASSERT( srx_Match( R, "caaaaaaaaaab", 1 ) );
+		RX_ASSERT( !srx_Match( R, "caaab", 0 ) && !srx_MatchAt( R, SLB( "caaab" ), 0 ) );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.calls == 3 && st.matches == 1 );
+		srx_Destroy( R );
+	}
+	{
+		char out[ 256 ] = "";
+		srx_Stream* S;
+		R = srx_Create( "ab", "y" );
+		S = srx_CreateStream( R, collect_matches, out );
+		RX_ASSERT( srx_StreamFeed( S, "aba", 3 ) && !srx_StreamFeed( S, "bxab", 4 ) );
+		RX_ASSERT( !srx_StreamFinish( S ) && strcmp( out, "[0-2][2-4]" ) == 0 );
+		srx_DestroyStream( S );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> leftmost-longest tests\n\n" );
+	MATCHTEST2( "", "a*", "l", 0 );
+	LONGTEST( "int integer", "int|integer", "[0-3][4-11]" );
+	LONGTEST( "abcd", "(a|ab)(c|bcd)", "[0-4 - -]" );
+	LONGTEST( "xabcabcy", "(a|b|c)*c", "[1-7 -]" );
+	LONGTEST( "aaab aaaa", "a|aa|a+b", "[0-4][5-7][7-9]" );
+	LONGTEST( "abcd cd", "abcd|c", "[0-4][5-6]" );
+	LONGTEST( "foo.tar.gz x.gz", "[a-z]+(\\.[a-z]+)*?", "[0-10 -][11-15 -]" );
+	LONGTEST( "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "(a|aa)*b", "" );
+	REPTEST2( "int integer", "int|integer", "l", "<\\0>", "<int> <integer>" );
+	COMPTEST2( "(a)\\1", "l", RXEAUTO );
+	COMPTEST2( "^a", "ml", RXEAUTO );
+	ANALYZETEST2( "int|integer", "l", RX_AF_AUTOMATON, RX_COST_LINEAR, RX_ENGINE_DFA_LONGEST );
+	STREAMTEST2( "integer int inte", "int|integer", "l", "[0-7][8-11][12-15]" );
+	STREAMTEST2( "ab abb", "ab+$|a", "l", "[0-1][3-6]" );
+	partest_ext( "int integer intege", "int|integer", "l" );
+	LANETEST2( "(a|ab)(c|bcd)", "l" );
+	printf( "longest match at: " );
+	{
+		size_t cbeg, cend;
+		R = srx_Create( "(a|ab)(c|bcd)?", "l" );
+		RX_ASSERT( srx_MatchAt( R, SLB( "xabcd" ), 1 ) );
+		RX_ASSERT( srx_GetCaptured( R, 0, &cbeg, &cend ) && cbeg == 1 && cend == 5 && !srx_GetCaptured( R, 1, NULL, NULL ) );
+		RX_ASSERT( !srx_MatchAt( R, SLB( "xabcd" ), 0 ) );
+		srx_Destroy( R );
+		R = srx_Create( "a+|b", "ly" );
+		RX_ASSERT( srx_Match( R, "baa", 1 ) && srx_GetCaptured( R, 0, &cbeg, &cend ) && cend == 3 );
+		RX_ASSERT( !srx_Match( R, "xaa", 0 ) );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	printf( "longest match on long inputs: " );
+	{
+		static char str[ 40001 ];
+		srx_Stats st;
+		size_t cbeg, cend;
+		memset( str, 'a', 40000 );
+		str[ 40000 ] = '2';
+		R = srx_Create( "[a-z]+1|2", "l" );
+		RX_ASSERT( srx_MatchExt( R, str, 40001, 0 ) && srx_GetCaptured( R, 0, &cbeg, &cend ) && cbeg == 40000 && cend == 40001 );
+		srx_GetStats( R, &st );
+		/* the anchored DFA only runs from the first possible start, not from every offset */
+		RX_ASSERT( st.steps == 1 );
+		RX_ASSERT( !srx_MatchExt( R, str, 40000, 0 ) );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> reverse tests\n\n" );
+	FINDTEST( "a.png b.jpg", "\\.(jpg|png)$", "[7-11 8-11]" );
+	FINDTEST( "a.png", "\\.(jpg|png)$", "[1-5 2-5]" );
+	FINDTEST( "aab ab", "(a|ab)+b$", "[4-6 4-5]" );
+	FINDTEST( "ab\nab", "^ab$|b$", "[4-5]" );
+	FINDTEST( "abab", "^(ab)*$", "[0-4 2-4]" );
+	MATCHTEST( "x.png.txt", "\\.(jpg|png)$", 0 );
+	MATCHTEST2( "X.PNG", "\\.(jpg|png)$", "i", 1 );
+	ANALYZETEST( "\\.(jpg|png)$", RX_AF_ANCHORED_END | RX_AF_AUTOMATON | RX_AF_ONE_PASS, RX_COST_LINEAR, RX_ENGINE_REVERSE );
+	ANALYZETEST( "(a)\\1$", RX_AF_ANCHORED_END | RX_AF_BACKREF, RX_COST_LINEAR, RX_ENGINE_BACKTRACK );
+	LASTTEST( "ab ab abb", "ab+", "[6-9]" );
+	LASTTEST( "aaa", "aa", "[1-3]" );
+	LASTTEST( "xa.png.jpg", "\\.(jpg|png)", "[6-10 7-10]" );
+	LASTTEST( "abcb", "(a|b)(c)?", "[3-4 3-4 -]" );
+	LASTTEST( "bab", "^b|a", "[1-2]" );
+	LASTTEST( "bxb", "^b*", "[0-1]" );
+	LASTTEST( "bxx", "x?$", "[2-3]" );
+	LASTTEST( "ab", "a*", "[1-1]" );
+	LASTTEST( "abab", "(a)b\\1", "[0-3 0-1]" );
+	LASTTEST( "none", "z", "" );
+	LASTTEST2( "AbAb", "ab", "i", "[2-4]" );
+	LASTTEST2( "int integer", "int|integer", "l", "[4-11]" );
+	printf( "sticky last match: " );
+	{
+		size_t cbeg, cend;
+		R = srx_Create( "ab", "y" );
+		RX_ASSERT( srx_MatchLast( R, SLB( "abab" ), 0 ) && srx_GetCaptured( R, 0, &cbeg, &cend ) && cbeg == 0 && cend == 2 );
+		RX_ASSERT( !srx_MatchLast( R, SLB( "abab" ), 1 ) && !srx_MatchLast( R, SLB( "abab" ), 4 ) );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> two-phase tests\n\n" );
+	TWOPHASETEST( '-', "ab1-2 x", "(\\d)-(\\d)", "[302-305 302-303 304-305]" );
+	TWOPHASETEST( '-', "aab", "(a|ab)(c|b)?", "[300-301 300-301 -]" );
+	TWOPHASETEST( '-', "aab-ab", "(a|ab)+b", "[300-303 301-302]" );
+	TWOPHASETEST( 'x', "y", "x*y", "[0-301]" );
+	TWOPHASETEST( ' ', "word", "w(o|or)(r|d)+", "[300-304 301-302 303-304]" );
+	TWOPHASETEST( 'a', "ac", "(a|ab)*c", "[0-302 300-301]" );
+	TWOPHASETEST( '-', "", "a*", "[0-0]" );
+	TWOPHASETEST2( '-', "xABAC", "(a|b)+c", "i", "[301-305 303-304]" );
+	ANALYZETEST( "^(a+)+b", RX_AF_NESTED_REPEAT | RX_AF_ANCHORED_START | RX_AF_AUTOMATON, RX_COST_EXPONENTIAL, RX_ENGINE_DFA_FILTER );
+	printf( "exponential two-phase: " );
+	{
+		char str[ 64 ];
+		srx_Stats st;
+		size_t cbeg, cend;
+		memset( str, 'a', 64 );
+		R = srx_Create( "(a+)+b", "" );
+		/* no match is found by the automata alone, on short inputs too */
+		RX_ASSERT( !srx_MatchExt( R, str, 64, 0 ) );
+		srx_GetStats( R, &st );
+		RX_ASSERT( st.steps == 0 );
+		str[ 40 ] = 'b';
+		RX_ASSERT( srx_MatchExt( R, str, 64, 0 ) && srx_GetCaptured( R, 1, &cbeg, &cend ) && cbeg == 0 && cend == 40 );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> bit-parallel tests\n\n" );
+	BITPARTEST( '-', "ab1-2 x", "(\\d)-(\\d)", "[302-305 302-303 304-305]" );
+	BITPARTEST( '-', "aab-ab", "(a|ab)+b", "[300-303 301-302]" );
+	BITPARTEST( 'x', "y", "x*y", "[0-301]" );
+	BITPARTEST( 'a', "ac", "(a|ab)*c", "[0-302 300-301]" );
+	BITPARTEST( '-', "", "a*", "[0-0]" );
+	BITPARTEST( '-', "", "-+b?", "[0-300]" );
+	BITPARTEST( 'b', "ab", "ab|b", "[0-1]" );
+	BITPARTEST( '-', "id: alpha_beta9 x", "id: ([a-z]+)_([a-z]+)(\\d)", "[300-315 304-309 310-314 314-315]" );
+	BITPARTEST( '=', "a=abcdefghijkl=", "abcdefghijk(l|m)", "[302-314 313-314]" );
+	BITPARTEST2( '-', "xABAC", "(a|b)+c", "i", "[301-305 303-304]" );
+	/* more positions than one word holds */
+	BITPARTEST( '-', "fox", "the quick brown fox jumps over the lazy dog and keeps running to the hills and far away|fox", "[300-303]" );
+	printf( "bit-parallel fallback: " );
+	{
+		char str[ 600 ];
+		size_t cbeg, cend;
+		memset( str, 'a', 600 );
+		str[ 586 ] = 'b';
+		str[ 599 ] = 'z';
+		R = srx_Create( "(a|b)*b(a|b){12}z", "" );
+		RX_ASSERT( R->analysis.engine == RX_ENGINE_TWO_PHASE );
+		/* the DFAs remembering the last 13 characters outgrow their state limit */
+		RX_ASSERT( srx_MatchExt( R, str, 600, 0 ) && srx_GetCaptured( R, 0, &cbeg, &cend ) && cbeg == 0 && cend == 600 );
+		RX_ASSERT( R->analysis.engine == RX_ENGINE_BIT_PARALLEL );
+		RX_ASSERT( !srx_MatchExt( R, str, 599, 0 ) );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> one-pass tests\n\n" );
+	ONEPASSTEST( "12-345-abc", "^(\\d+)-(\\d+)-(\\w+)$", 1, "[0-10 0-2 3-6 7-10]" );
+	ONEPASSTEST( "1-2-x 1-2-", "^(\\d+)-(\\d+)-(\\w+)$", 1, "" );
+	ONEPASSTEST( "a@b.com x@y.org", "(\\w+)@(\\w+)\\.com", 1, "[0-7 0-1 2-3]" );
+	ONEPASSTEST( "xabcdy xaby xy", "x(ab|cd)+y", 1, "[0-6 3-5][7-11 8-10]" );
+	ONEPASSTEST( "aab ab b", "(a)*(b)", 1, "[0-3 1-2 2-3][4-6 4-5 5-6][7-8 - 7-8]" );
+	ONEPASSTEST( "abab aba", "(ab)+(a)?", 0, "[0-4 2-4 -][5-8 5-7 7-8]" );
+	ONEPASSTEST( "aaa", "a{2}?(a)??", 1, "[0-2 -]" );
+	ONEPASSTEST( "abc ab", "(a)(b)(c)?$", 1, "[4-6 4-5 5-6 -]" );
+	ONEPASSTEST( "abcd abd", "ab(cd|c)?d?", 0, "[0-4 2-4][5-8 -]" );
+	ONEPASSTEST( "aaab", "(a|ab)(c|b)?", 0, "[0-1 0-1 -][1-2 1-2 -][2-4 2-3 3-4]" );
+	ONEPASSTEST( "a.b..c", "[^.]*\\.", 1, "[0-2][2-4][4-5]" );
+	ONEPASSTEST2( "AbC abc", "a(b)c", "i", 1, "[0-3 1-2][4-7 5-6]" );
+	ONEPASSTEST2( "ab ab", "ab", "y", 1, "[0-2]" );
+	ONEPASSTEST( "abab", "(a)b\\1", 0, "[0-3 0-1]" );
+	printf( "one-pass stacks: " );
+	{
+		srx_Stats st;
+		R = srx_Create( "(\\d+)-(\\d+)", "" );
+		RX_ASSERT( srx_Match( R, "id 12-345", 0 ) );
+		srx_GetStats( R, &st );
+		/* no backtracking stack or repeat counters */
+		RX_ASSERT( st.starts == 4 && st.backtracks == 0 && st.max_depth == 0 && st.reallocs == 0 );
+		RX_ASSERT( R->states_mem == 0 && R->iternum_mem == 0 );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	printf( "\n> counted repeat tests\n\n" );
+	COUNTTEST( "x1f2e3dz 12345", "[0-9a-f]{6}", "[1-7]" );
+	COUNTTEST( "aaaaa", "a{2}", "[0-2][2-4]" );
+	COUNTTEST( "aaaab", "a{2,3}ab", "[0-5]" );
+	COUNTTEST( "aaaab", "a{2,3}?", "[0-2][2-4]" );
+	COUNTTEST( "abbbc abc", "ab{2,}?c", "[0-5]" );
+	COUNTTEST( "xxx-yy-z", "[^-]{1,2}-", "[1-4][4-7]" );
+	COUNTTEST( "a.b..c", "[^.]*\\.", "[0-2][2-4][4-5]" );
+	COUNTTEST( "key=val;k=v;", "\\w+=\\w{0,5};", "[0-8][8-12]" );
+	COUNTTEST( "abab xaab", "a{0,3}b", "[0-2][2-4][6-9]" );
+	COUNTTEST( "ab\nab", ".{1,3}b", "[0-2][3-5]" );
+	COUNTTEST2( "AaAb aB", "a{2,}b", "i", "[0-4]" );
+	COUNTTEST2( "XyZ12", "[a-z]{3}", "i", "[0-3]" );
+	COUNTTEST( "ab12", "\\d{3}", "" );
+	printf( "counted repeat stacks: " );
+	{
+		char str[ 3000 ];
+		srx_Stats st;
+		size_t cbeg, cend;
+		memset( str, 'f', 3000 );
+		str[ 2999 ] = 'x';
+		R = no_onepass( srx_Create( "[0-9a-f]{64}x", "" ) );
+		R->analysis.engine = RX_ENGINE_BACKTRACK;
+		RX_ASSERT( srx_MatchExt( R, str, 3000, 0 ) && srx_GetCaptured( R, 0, &cbeg, &cend ) && cbeg == 2935 && cend == 3000 );
+		srx_GetStats( R, &st );
+		/* one state for the whole repeat, whatever the count */
+		RX_ASSERT( st.max_depth <= 4 && st.backtracks == 0 && R->iternum_mem == 0 );
+		srx_Destroy( R );
+		R = no_onepass( srx_Create( "^.{1,2000}x", "" ) );
+		R->analysis.engine = RX_ENGINE_BACKTRACK;
+		RX_ASSERT( !srx_MatchExt( R, str, 2999, 0 ) );
+		RX_ASSERT( srx_MatchExt( R, str + 999, 2001, 0 ) && srx_GetCaptured( R, 0, &cbeg, &cend ) && cend == 2001 );
+		srx_GetStats( R, &st );
+		/* giving back characters only stops where an "x" follows */
+		RX_ASSERT( st.max_depth <= 4 && st.backtracks <= 2 && R->iternum_mem == 0 );
+		srx_Destroy( R );
+	}
+	puts( "" );
+	
+	/* strings that do not fit the offset width are rejected instead of producing garbage */
+	printf( "\n> limit tests\n\n" );
+	R = srx_Create( "a", "" );
+	RX_ASSERT( srx_MatchExt( R, "a", 1, 0 ) == 1 );
+	RX_ASSERT( srx_MatchExt( R, "a", (size_t) RX_MAX_OFFSET + 1, 0 ) == 0 );
+	srx_Destroy( R );
+	puts( "" );
+	
 	puts( "=== all tests done! ===" );
 	
 	return 0;
@@ -0,0 +1,175 @@
+
+#include "sgregex.c"
+#include "sgregex.hpp"
+
+static void _failed( const char* msg, int line ){ printf( "\nERROR: condition failed - \"%s\"\n\tline %d\n", msg, line ); exit( 1 ); }
+#define RX_ASSERT( cond ) if( !(cond) ) _failed( #cond, __LINE__ ); else printf( "+" );
+
+
+/* the compile-time program must be the one srx_CreateExt builds */
+static int same_program( const srx_Program& P, const char* pattern, const char* mods )
+{
+	size_t i;
+	int err[ 2 ];
+	srx_Context* R = srx_CreateExt( pattern, strlen( pattern ), mods, err, NULL, NULL );
+	int same = R != NULL && P.capture_count == R->capture_count;
+	for( i = 0; same && i < P.instrs_count; ++i )
+	{
+		const rxInstr* I = &R->instrs[ i ];
+		same = P.instrs[ i ].op == I->op && P.instrs[ i ].start == I->start &&
+			P.instrs[ i ].from == I->from && P.instrs[ i ].len == I->len;
+	}
+	same = same && R->instrs[ P.instrs_count - 1 ].op == RX_OP_MATCH_DONE;
+	for( i = 0; same && i < P.chars_count; ++i )
+		same = P.chars[ i ] == R->chars[ i ];
+	if( R )
+		srx_Destroy( R );
+	return same;
+}
+#define CTTEST( pat, mods ) RX_ASSERT( same_program( srx::ct::program< pat, mods >, pat, mods ) )
+
+/* errors are the same as those of srx_CreateExt */
+template< srx::ct::fixed_string Pattern, srx::ct::fixed_string Mods > static int same_error( int code, int pos )
+{
+	int err[ 2 ];
+	srx_Context* R = srx_CreateExt( Pattern.data, Pattern.size(), Mods.data, err, NULL, NULL );
+	if( R )
+		srx_Destroy( R );
+	return err[0] == code && err[1] == pos &&
+		srx::ct::compile_result< Pattern, Mods >.errcode == code && srx::ct::compile_result< Pattern, Mods >.errpos == pos;
+}
+#define ERRTEST( pat, mods, code, pos ) RX_ASSERT( ( same_error< pat, mods >( code, pos ) ) )
+
+static std::string spans_of( srx::regex& re, std::string_view s )
+{
+	std::string out;
+	for( const srx::match& m : re.find_all( s ) )
+	{
+		out += "[";
+		for( int i = 0; i < m.size(); ++i )
+			out += ( i ? "," : "" ) + std::string( m[ i ] );
+		out += "]";
+	}
+	return out;
+}
+#define MATCHTEST( pat, mods, str ) { srx::ct::regex< pat, mods > a; srx::regex b( pat, mods ); RX_ASSERT( spans_of( a, str ) == spans_of( b, str ) ); }
+
+
+/* everything is known at compile time */
+static_assert( srx::ct::program< "a(b|c)+d" >.instrs_count == 13 );
+static_assert( srx::ct::program< "a(b|c)+d" >.capture_count == 2 );
+static_assert( srx::ct::program< "abc" >.instrs[ 1 ].op == RX_OP_MATCH_STRING && srx::ct::program< "abc" >.instrs[ 1 ].len == 3 );
+static_assert( srx::ct::compile_result< "a)" >.errcode == RXEUNEXP && srx::ct::compile_result< "a)" >.errpos == 1 );
+static_assert( srx::ct::compile_result< "a", "x" >.errcode == RXEINMOD );
+
+
+int main()
+{
+	printf( "\n> C++20 compile-time compilation tests\n\n" );
+	
+	printf( "programs: " );
+	CTTEST( "a", "" );
+	CTTEST( "abc", "" );
+	CTTEST( "a|b", "" );
+	CTTEST( "GET|POST", "" );
+	CTTEST( "(a|b)+c", "" );
+	CTTEST( "(a|bc)d", "" );
+	CTTEST( "[a-z0-9_]+", "" );
+	CTTEST( "[^\\d\\s-]", "" );
+	CTTEST( "[]a]", "" );
+	CTTEST( "[a-]x", "" );
+	CTTEST( "a{2,5}?b{3}c{2,}", "" );
+	CTTEST( "ab*?c??d+?", "" );
+	CTTEST( "\\w+@\\d\\h\\v", "" );
+	CTTEST( "\\W\\S\\D\\H\\V", "" );
+	CTTEST( "^x$", "m" );
+	CTTEST( ".*", "" );
+	CTTEST( ".*", "s" );
+	CTTEST( "(a)(b)\\2\\1", "i" );
+	CTTEST( "((((a))))", "" );
+	CTTEST( "(a(b(c)))|d", "" );
+	CTTEST( "x\\.y\\+\\\\", "" );
+	CTTEST( "abc(de)+fg", "" );
+	CTTEST( "((((((((((((x))))))))))))", "" );
+	CTTEST( "(a*)*b", "" );
+	CTTEST( "a{0}", "" );
+	CTTEST( "a+", "iy" );
+	CTTEST( "int|integer", "l" );
+	puts( "" );
+	
+	printf( "errors: " );
+	ERRTEST( "a)", "", RXEUNEXP, 1 );
+	ERRTEST( "a", "mx", RXEINMOD, 1 );
+	ERRTEST( "", "", RXEEMPTY, 0 );
+	ERRTEST( "()", "", RXEUNEXP, 1 );
+	ERRTEST( "a|", "", RXEPART, 2 );
+	ERRTEST( "[a", "", RXEPART, 2 );
+	ERRTEST( "[z-a]", "", RXERANGE, 2 );
+	ERRTEST( "a{3,2}", "", RXERANGE, 5 );
+	ERRTEST( "a{99999999999}", "", RXELIMIT, 12 );
+	ERRTEST( "a**", "", RXEUNEXP, 2 );
+	ERRTEST( "*a", "", RXEUNEXP, 0 );
+	ERRTEST( "(a)\\2", "", RXENOREF, 5 );
+	ERRTEST( "a\\", "", RXEPART, 2 );
+	ERRTEST( "a}", "", RXEUNEXP, 1 );
+	puts( "" );
+	
+	printf( "matching: " );
+	MATCHTEST( "(\\d+)-(\\d+)", "", "1-2 34-56 7-" );
+	MATCHTEST( "(a|ab)(c|bcd)(d*)", "", "abcd abcdd" );
+	MATCHTEST( "^\\w+$", "m", "one\ntwo three\nfour" );
+	MATCHTEST( "A.B", "is", "a\nb axb" );
+	MATCHTEST( "(a|a)*b", "", "aaaaaaaaaaaaaaaaaaaaaaaaa" );
+	MATCHTEST( "(\\w)\\1", "", "abba xyz zz" );
+	MATCHTEST( "\\w", "y", "ab c" );
+	{
+		srx::ct::regex< "(\\w+)@(\\w+)" > re;
+		std::string out;
+		RX_ASSERT( re.group_count() == 3 && re.replace( "a@b c@d", "$2.$1", out ) == 2 && out == "b.a d.c" );
+		RX_ASSERT( srx_GetCaptureCount( re.native_handle() ) == 3 );
+	}
+	{
+		/* the pattern is kept for the slow-call callback */
+		srx::ct::regex< "x+y" > re;
+		RX_ASSERT( strcmp( re.native_handle()->pattern, "x+y" ) == 0 );
+		srx_Analysis A;
+		srx_Analyze( re.native_handle(), &A );
+		RX_ASSERT( A.min_length == 2 );
+	}
+	puts( "" );
+	
+	printf( "program checks: " );
+	{
+		srx_Program P = srx::ct::program< "(a)[b-c]\\1" >;
+		srx_Instr instrs[ 16 ];
+		int err[ 2 ];
+		srx_Context* R;
+		
+		RX_ASSERT( P.instrs_count <= 16 );
+		memcpy( instrs, P.instrs, sizeof(srx_Instr) * P.instrs_count );
+		P.instrs = instrs;
+		R = srx_CreateProgram( &P, err, NULL, NULL );
+		RX_ASSERT( R && err[0] == RXSUCCESS && srx_Match( R, "xaba", 0 ) );
+		srx_Destroy( R );
+		
+		RX_ASSERT( instrs[ 4 ].op == RX_OP_MATCH_CHARSET && instrs[ 5 ].op == RX_OP_MATCH_BACKREF );
+		instrs[ 4 ].len = 4; /* charset past the character data */
+		RX_ASSERT( !srx_CreateProgram( &P, err, NULL, NULL ) && err[0] == RXEPROG && err[1] == 4 );
+		instrs[ 4 ].len = 2;
+		instrs[ 5 ].from = 2; /* backreference to a missing capture */
+		RX_ASSERT( !srx_CreateProgram( &P, err, NULL, NULL ) && err[0] == RXEPROG && err[1] == 5 );
+		instrs[ 5 ].from = 1;
+		instrs[ 2 ].op = 13;
+		RX_ASSERT( !srx_CreateProgram( &P, err, NULL, NULL ) && err[0] == RXEPROG && err[1] == 2 );
+		instrs[ 2 ].op = RX_OP_MATCH_STRING;
+		P.mods = "q";
+		RX_ASSERT( !srx_CreateProgram( &P, err, NULL, NULL ) && err[0] == RXEINMOD && err[1] == 0 );
+		P.mods = NULL;
+		P.instrs_count--; /* no MATCH_DONE */
+		RX_ASSERT( !srx_CreateProgram( &P, err, NULL, NULL ) && err[0] == RXEPROG );
+	}
+	puts( "" );
+	
+	printf( "\n=== all tests done! ===\n\n" );
+	return 0;
+}
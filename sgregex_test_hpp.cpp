@@ -0,0 +1,173 @@
+
+#include "sgregex.c"
+#include "sgregex.hpp"
+
+#include <vector>
+
+static void _failed( const char* msg, int line ){ printf( "\nERROR: condition failed - \"%s\"\n\tline %d\n", msg, line ); exit( 1 ); }
+#define RX_ASSERT( cond ) if( !(cond) ) _failed( #cond, __LINE__ ); else printf( "+" );
+
+
+/* counts live blocks and bytes to check that all allocations go through the resource and are returned */
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+	size_t allocs = 0, live = 0, live_bytes = 0;
+
+private:
+	void* do_allocate( size_t bytes, size_t align ) override
+	{
+		allocs++;
+		live++;
+		live_bytes += bytes;
+		return std::pmr::new_delete_resource()->allocate( bytes, align );
+	}
+	void do_deallocate( void* p, size_t bytes, size_t align ) override
+	{
+		live--;
+		live_bytes -= bytes;
+		std::pmr::new_delete_resource()->deallocate( p, bytes, align );
+	}
+	bool do_is_equal( const std::pmr::memory_resource& o ) const noexcept override { return this == &o; }
+};
+
+static std::string spans_of( srx::regex& re, std::string_view s )
+{
+	std::string out;
+	for( const srx::match& m : re.find_all( s ) )
+	{
+		out += "[" + std::string( m.str() ) + "]";
+		RX_ASSERT( m.str().data() == s.data() + m.position() ); /* views the input */
+	}
+	return out;
+}
+
+
+int main()
+{
+	printf( "\n> C++ wrapper tests\n\n" );
+	
+	printf( "errors: " );
+	try
+	{
+		srx::regex bad( "a)" );
+		RX_ASSERT( !"no exception" );
+	}
+	catch( const srx::error& e )
+	{
+		RX_ASSERT( e.code() == RXEUNEXP && e.position() == 1 );
+	}
+	try
+	{
+		srx::regex bad( "a", "x" );
+		RX_ASSERT( !"no exception" );
+	}
+	catch( const srx::error& e )
+	{
+		RX_ASSERT( e.code() == RXEINMOD && e.position() == 0 );
+	}
+	puts( "" );
+	
+	printf( "search: " );
+	{
+		srx::regex re( "(\\d+)-(x)?(\\d+)" );
+		std::string_view s = "id 12-345 end";
+		srx::match m = re.search( s );
+		RX_ASSERT( m && m.size() == 4 && re.group_count() == 4 );
+		RX_ASSERT( m.str() == "12-345" && m[1] == "12" && m[3] == "345" );
+		RX_ASSERT( !m.matched( 2 ) && m[2].empty() && m.position( 2 ) == RX_NOPOS );
+		RX_ASSERT( m.position() == 3 && m.length() == 6 );
+		RX_ASSERT( !m.matched( 7 ) && !m.matched( -1 ) );
+		RX_ASSERT( re.test( s ) && !re.test( s, 9 ) );
+		RX_ASSERT( !re.search( s, m, 9 ) && !m && m.size() == 0 );
+		/* sizes are explicit, the input does not need to be null-terminated */
+		RX_ASSERT( !re.test( std::string_view( "1-23", 2 ) ) && re.test( std::string_view( "1-23", 3 ) ) );
+		/* only at the offset */
+		RX_ASSERT( !re.match_at( s, 2 ) && re.match_at( s, 3 ).str() == "12-345" && re.match_at( s, 4 ).str() == "2-345" );
+		RX_ASSERT( !re.match_at( s, m, 20 ) && !m );
+		RX_ASSERT( re.search_last( "1-2 3-4 x" ).str() == "3-4" && !re.search_last( "1-2 3-4", 5 ) );
+		RX_ASSERT( re.search_last( s ).str() == "2-345" ); /* starts last, overlapping the first match */
+	}
+	puts( "" );
+	
+	printf( "find_all: " );
+	{
+		srx::regex re( "[a-z]+" ), empty( "x*" );
+		RX_ASSERT( spans_of( re, "ab, cd e1" ) == "[ab][cd][e]" );
+		RX_ASSERT( spans_of( re, "123" ) == "" );
+		RX_ASSERT( spans_of( empty, "axxb" ) == "[][xx][]" );
+		{
+			int count = 0;
+			srx::match_range r = re.find_all( "one two three", 4 );
+			for( srx::match_iterator it = r.begin(); it != r.end(); it++ )
+				count += it->size();
+			RX_ASSERT( count == 2 );
+		}
+	}
+	puts( "" );
+	
+	printf( "move: " );
+	{
+		srx::regex a( "b+" );
+		srx::regex b( std::move( a ) );
+		RX_ASSERT( a.native_handle() == nullptr && b.test( "abbc" ) );
+		srx::regex c( "x" );
+		c = std::move( b );
+		RX_ASSERT( c.test( "abbc" ) && !c.test( "x" ) );
+		std::vector< srx::regex > v;
+		v.emplace_back( "a" );
+		v.emplace_back( "b" );
+		v.emplace_back( "c" );
+		RX_ASSERT( v[2].test( "c" ) && !v[0].test( "c" ) );
+	}
+	puts( "" );
+	
+	printf( "replace: " );
+	{
+		srx::regex re( "(\\w+)@(\\w+)" );
+		std::string out = "> ";
+		RX_ASSERT( re.replace( "mail a@b and c@d", "$2 at \\1", out ) == 2 );
+		RX_ASSERT( out == "> mail b at a and d at c" );
+		
+		srx::replacement rep( re, "<\\0>" );
+		out.clear();
+		RX_ASSERT( re.replace( "x@y", rep, out ) == 1 && out == "<x@y>" );
+		
+		out.clear();
+		RX_ASSERT( re.replace_with( "a@b c@d", out, []( const srx::match& m, std::string& o ){ o += m[2]; o += m[1]; } ) == 2 );
+		RX_ASSERT( out == "ba dc" );
+		
+		out.clear();
+		RX_ASSERT( re.replace_with( "a@b c@d e@f", out, []( const srx::match& m, std::string& o ){ o += "#"; return m[1] != "c"; } ) == 2 );
+		RX_ASSERT( out == "# # e@f" );
+	}
+	puts( "" );
+	
+	printf( "pmr: " );
+	{
+		counting_resource mr;
+		{
+			srx::regex re( "(a|b)+c", "", &mr );
+			std::string out;
+			size_t before;
+			RX_ASSERT( mr.allocs > 0 && mr.live > 0 );
+			RX_ASSERT( spans_of( re, "abc bac ccc" ) == "[abc][bac]" );
+			before = mr.allocs;
+			RX_ASSERT( re.replace( "aac", "-", out ) == 1 && out == "-" );
+			RX_ASSERT( mr.allocs > before ); /* the replacement template */
+		}
+		RX_ASSERT( mr.live == 0 && mr.live_bytes == 0 );
+		
+		/* reallocation keeps the contents (long input grows the matcher stacks) */
+		{
+			std::string s( 5000, 'a' );
+			srx::regex re( "a{1,9999}b|a+$", "", &mr );
+			RX_ASSERT( re.search( s ).length() == 5000 );
+		}
+		RX_ASSERT( mr.live == 0 );
+	}
+	puts( "" );
+	
+	printf( "\n=== all tests done! ===\n\n" );
+	return 0;
+}